@@ -0,0 +1,193 @@
+// Contention benchmark: mutex + hh_std::queue against mpmc_queue and spsc_queue.
+//
+//   g++ -std=c++11 -O2 -pthread -I../source bench_concurrent_queue.cpp -o bench_concurrent_queue
+//   ./bench_concurrent_queue [items per producer] [max threads per side]
+//
+// Every producer pushes the same number of longs and the consumers pop until
+// all are drained; the table shows million items per second (higher is better).
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<mutex>
+#include<thread>
+#include<vector>
+#include<atomic>
+#include "hh_stl_queue.h"
+#include "hh_stl_concurrent_queue.h"
+
+namespace {
+
+const size_t queue_capacity = 1024;
+const size_t batch = 32;
+
+// A bounded queue in the way the pipeline stages used it before.
+class locked_queue {
+    std::mutex m;
+    hh_std::queue<long> q;
+public:
+    bool try_push(long x) {
+        std::lock_guard<std::mutex> lock(m);
+        if(q.size() >= queue_capacity) {
+            return false;
+        }
+        q.push(x);
+        return true;
+    }
+    bool try_pop(long &x) {
+        std::lock_guard<std::mutex> lock(m);
+        if(q.empty()) {
+            return false;
+        }
+        x = q.top();
+        q.pop();
+        return true;
+    }
+};
+
+template <class Queue>
+struct single_ops {
+    static bool push(Queue &q, long x) {
+        return q.try_push(x);
+    }
+    static size_t pop(Queue &q, long *out) {
+        return q.try_pop(*out) ? 1 : 0;
+    }
+};
+
+template <class Queue>
+struct batch_ops {
+    static size_t push_n(Queue &q, const long *in, size_t n) {
+        return q.try_push_n(in, n);
+    }
+    static size_t pop(Queue &q, long *out) {
+        return q.try_pop_n(out, batch);
+    }
+};
+
+// Returns million items per second.
+template <class Queue, class Ops>
+double run_single(Queue &q, int producers, int consumers, long items) {
+    std::atomic<long> left(items * producers);
+    std::atomic<long> sum(0);
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int p = 0; p < producers; ++p) {
+        threads.push_back(std::thread([&] {
+            for(long i = 1; i <= items; ++i) {
+                while(!Ops::push(q, i)) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for(int c = 0; c < consumers; ++c) {
+        threads.push_back(std::thread([&] {
+            long buf[batch];
+            long local = 0;
+            while(left.load(std::memory_order_relaxed) > 0) {
+                size_t n = Ops::pop(q, buf);
+                if(n == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for(size_t i = 0; i < n; ++i) {
+                    local += buf[i];
+                }
+                left.fetch_sub(long(n), std::memory_order_relaxed);
+            }
+            sum += local;
+        }));
+    }
+    for(size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(sum.load() != producers * (items * (items + 1) / 2)) {
+        std::printf("checksum mismatch\n");
+        std::exit(1);
+    }
+    return double(items) * producers / secs / 1e6;
+}
+
+template <class Queue>
+double run_batch(Queue &q, int producers, int consumers, long items) {
+    std::atomic<long> left(items * producers);
+    std::atomic<long> sum(0);
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int p = 0; p < producers; ++p) {
+        threads.push_back(std::thread([&] {
+            long buf[batch];
+            for(long i = 1; i <= items; ) {
+                size_t n = 0;
+                for(; n < batch && i + long(n) <= items; ++n) {
+                    buf[n] = i + long(n);
+                }
+                size_t done = 0;
+                while(done < n) {
+                    size_t k = batch_ops<Queue>::push_n(q, buf + done, n - done);
+                    if(k == 0) {
+                        std::this_thread::yield();
+                    }
+                    done += k;
+                }
+                i += long(n);
+            }
+        }));
+    }
+    for(int c = 0; c < consumers; ++c) {
+        threads.push_back(std::thread([&] {
+            long buf[batch];
+            long local = 0;
+            while(left.load(std::memory_order_relaxed) > 0) {
+                size_t n = batch_ops<Queue>::pop(q, buf);
+                if(n == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for(size_t i = 0; i < n; ++i) {
+                    local += buf[i];
+                }
+                left.fetch_sub(long(n), std::memory_order_relaxed);
+            }
+            sum += local;
+        }));
+    }
+    for(size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(sum.load() != producers * (items * (items + 1) / 2)) {
+        std::printf("checksum mismatch\n");
+        std::exit(1);
+    }
+    return double(items) * producers / secs / 1e6;
+}
+
+}
+
+int main(int argc, char **argv) {
+    long items = argc > 1 ? std::atol(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    std::printf("%-8s %12s %12s %12s\n", "P x C", "mutex", "mpmc", "mpmc batch");
+    for(int t = 1; t <= max_threads; t *= 2) {
+        locked_queue lq;
+        hh_std::mpmc_queue<long> mq(queue_capacity);
+        hh_std::mpmc_queue<long> bq(queue_capacity);
+        double a = run_single<locked_queue, single_ops<locked_queue> >(lq, t, t, items);
+        double b = run_single<hh_std::mpmc_queue<long>, single_ops<hh_std::mpmc_queue<long> > >(mq, t, t, items);
+        double c = run_batch(bq, t, t, items);
+        std::printf("%dx%-6d %12.1f %12.1f %12.1f\n", t, t, a, b, c);
+    }
+
+    std::printf("\n%-8s %12s %12s %12s\n", "1 x 1", "mutex", "spsc", "spsc batch");
+    locked_queue lq;
+    hh_std::spsc_queue<long> sq(queue_capacity);
+    hh_std::spsc_queue<long> bq(queue_capacity);
+    double a = run_single<locked_queue, single_ops<locked_queue> >(lq, 1, 1, items);
+    double b = run_single<hh_std::spsc_queue<long>, single_ops<hh_std::spsc_queue<long> > >(sq, 1, 1, items);
+    double c = run_batch(bq, 1, 1, items);
+    std::printf("%-8s %12.1f %12.1f %12.1f\n", "", a, b, c);
+    return 0;
+}
@@ -0,0 +1,116 @@
+// list::sort: the in-place chain merge against the pointer-buffer merge.
+//
+//   g++ -std=c++11 -O2 -I../source bench_list_sort.cpp -o bench_list_sort
+//   ./bench_list_sort
+//
+// Each list is sorted once before timing so its nodes are scattered in memory
+// relative to list order, which is the state of a long-lived list.  Times are
+// milliseconds per sort (lower is better).  list::sort itself picks the
+// buffered merge only for POD elements and at least 65536 nodes.
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<string>
+#include "hh_stl_list.h"
+
+namespace {
+
+template <class T>
+struct probe: public hh_std::list<T> {
+    template <class Order>
+    void sort_chain(Order order) {
+        this->__sort_chain(order);
+    }
+    template <class Order>
+    void sort_buffered(Order order) {
+        this->__sort_buffered(order, this->size());
+    }
+};
+
+unsigned long next_random(unsigned long &state) {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    return state >> 33;
+}
+
+void make_value(unsigned long r, int &x) {
+    x = int(r);
+}
+
+void make_value(unsigned long r, std::string &x) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key-%020lu", r);
+    x = buf;
+}
+
+template <class T>
+void refill(probe<T> &l, unsigned long seed) {
+    for(typename probe<T>::iterator it = l.begin(); it != l.end(); ++it) {
+        make_value(next_random(seed), *it);
+    }
+}
+
+template <class T>
+bool sorted(probe<T> &l) {
+    typename probe<T>::iterator it = l.begin(), prev = it;
+    for(++it; it != l.end(); prev = it, ++it) {
+        if(*it < *prev) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same convention as list::sort: true when b goes before a.
+template <class T>
+struct after {
+    bool operator() (const T &a, const T &b) const {
+        return b < a;
+    }
+};
+
+template <class T>
+void run(const char *name, size_t n, int reps) {
+    probe<T> l;
+    unsigned long seed = n;
+    for(size_t i = 0; i < n; ++i) {
+        T x;
+        make_value(next_random(seed), x);
+        l.push_back(x);
+    }
+    l.sort_chain(after<T>());
+    double chain = 0, buffered = 0;
+    for(int r = 0; r < reps; ++r) {
+        refill(l, seed + r);
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        l.sort_chain(after<T>());
+        chain += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if(!sorted(l)) {
+            std::printf("chain sort failed\n");
+            std::exit(1);
+        }
+        refill(l, seed + r);
+        t0 = std::chrono::steady_clock::now();
+        l.sort_buffered(after<T>());
+        buffered += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if(!sorted(l)) {
+            std::printf("buffered sort failed\n");
+            std::exit(1);
+        }
+    }
+    std::printf("%-8s %10zu %12.2f %12.2f %8.2fx\n", name, n, chain / reps, buffered / reps, chain / buffered);
+}
+
+}
+
+int main() {
+    std::printf("%-8s %10s %12s %12s %9s\n", "type", "n", "chain ms", "buffered ms", "speedup");
+    for(size_t n = 1024; n <= 4 * 1024 * 1024; n *= 4) {
+        int reps = n < 100000 ? 20 : 3;
+        run<int>("int", n, reps);
+    }
+    for(size_t n = 1024; n <= 1024 * 1024; n *= 4) {
+        int reps = n < 100000 ? 20 : 3;
+        run<std::string>("string", n, reps);
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Insert/erase churn on node containers, with and without node_cache_alloc.
+//
+//   g++ -std=c++11 -O2 -I../source bench_node_cache.cpp -o bench_node_cache
+//   ./bench_node_cache
+//
+// Each round inserts one key and erases the oldest, so the container size is
+// fixed and every erased node could serve the next insert.  Times are
+// nanoseconds per insert/erase pair (lower is better).  Add -D__USE_MALLOC to
+// compare against malloc instead of the default pool.
+#include<chrono>
+#include<cstdio>
+#include<functional>
+#include "hh_stl_list.h"
+#include "hh_stl_map.h"
+#include "hh_stl_hashmap.h"
+
+namespace {
+
+typedef hh_std::node_cache_alloc<hh_std::alloc> cache_alloc;
+
+const int rounds = 4000000;
+
+template <class Churn>
+double time_ns(Churn churn) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    long sink = churn();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    if(sink == -1) {
+        std::printf("unreachable\n");
+    }
+    return ns / rounds;
+}
+
+template <class Alloc>
+long list_churn(int live) {
+    hh_std::list<long, Alloc> l;
+    for(int i = 0; i < live; ++i) {
+        l.push_back(i);
+    }
+    for(int r = 0; r < rounds; ++r) {
+        l.push_back(r);
+        l.pop_front();
+    }
+    return l.front();
+}
+
+template <class Alloc>
+long map_churn(int live) {
+    hh_std::map<long, long, std::less<long>, Alloc> m;
+    for(int i = 0; i < live; ++i) {
+        m[i] = i;
+    }
+    for(long r = live; r < rounds + live; ++r) {
+        m[r] = r;
+        m.erase(r - live);
+    }
+    return m.begin()->second;
+}
+
+template <class Alloc>
+long hash_map_churn(int live) {
+    hh_std::hash_map<long, long, hh_std::hash<long>, std::equal_to<long>, Alloc> m;
+    for(int i = 0; i < live; ++i) {
+        m[i] = i;
+    }
+    for(long r = live; r < rounds + live; ++r) {
+        m[r] = r;
+        m.erase(r - live);
+    }
+    return long(m.size());
+}
+
+}
+
+int main() {
+    std::printf("%-10s %6s %10s %10s\n", "container", "live", "alloc ns", "cache ns");
+    for(int live = 16; live <= 4096; live *= 16) {
+        std::printf("%-10s %6d %10.1f %10.1f\n", "list", live,
+                    time_ns(std::bind(list_churn<hh_std::alloc>, live)),
+                    time_ns(std::bind(list_churn<cache_alloc>, live)));
+        std::printf("%-10s %6d %10.1f %10.1f\n", "map", live,
+                    time_ns(std::bind(map_churn<hh_std::alloc>, live)),
+                    time_ns(std::bind(map_churn<cache_alloc>, live)));
+        std::printf("%-10s %6d %10.1f %10.1f\n", "hash_map", live,
+                    time_ns(std::bind(hash_map_churn<hh_std::alloc>, live)),
+                    time_ns(std::bind(hash_map_churn<cache_alloc>, live)));
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// unrolled_list against list: full traversal and inserts at a held position.
+//
+//   g++ -std=c++11 -O2 -I../source bench_unrolled_list.cpp -o bench_unrolled_list
+//   ./bench_unrolled_list
+//
+// Both containers are built by inserting in front of a drifting cursor, so
+// list's nodes end up scattered in memory relative to list order.  Times are
+// milliseconds (lower is better).
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include "hh_stl_list.h"
+#include "hh_stl_unrolled_list.h"
+#include "hh_stl_numeric.h"
+
+namespace {
+
+unsigned long next_random(unsigned long &state) {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    return state >> 33;
+}
+
+double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Inserts n ints in front of a cursor that drifts forward at random, so
+// consecutive elements of the sequence were allocated far apart.
+template <class Container>
+double build(Container &c, size_t n) {
+    unsigned long seed = 1;
+    double t0 = now_ms();
+    typename Container::iterator it = c.end();
+    for(size_t i = 0; i < n; ++i) {
+        it = c.insert(it, int(i));
+        if(next_random(seed) & 1) {
+            ++it;
+        }
+    }
+    return now_ms() - t0;
+}
+
+template <class Container>
+double traverse(const Container &c, int reps, long &sum) {
+    double t0 = now_ms();
+    for(int r = 0; r < reps; ++r) {
+        sum += hh_std::accumulate(c.begin(), c.end(), 0L);
+    }
+    return (now_ms() - t0) / reps;
+}
+
+void run(size_t n) {
+    hh_std::list<int> l;
+    hh_std::unrolled_list<int> u;
+    double bl = build(l, n);
+    double bu = build(u, n);
+    long s1 = 0, s2 = 0;
+    int reps = n < 100000 ? 200 : 10;
+    double tl = traverse(l, reps, s1);
+    double tu = traverse(u, reps, s2);
+    if(s1 != s2) {
+        std::printf("sums differ\n");
+        std::exit(1);
+    }
+    std::printf("%10zu %10.2f %10.2f %10.3f %10.3f %8.2fx\n", n, bl, bu, tl, tu, tl / tu);
+}
+
+}
+
+int main() {
+    std::printf("%10s %10s %10s %10s %10s %9s\n", "n", "list ins", "unr ins", "list walk", "unr walk", "walk");
+    for(size_t n = 1024; n <= 4 * 1024 * 1024; n *= 4) {
+        run(n);
+    }
+    return 0;
+}
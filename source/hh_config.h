@@ -7,5 +7,7 @@
 #define __STL_NULL_TMPL_ARGS <>
 #define __STL_TRY try
 #define __STL_UNWIND(action) catch(...){action;throw;}
+// Separates fields that different threads write often, to avoid false sharing.
+#define __STL_CACHE_LINE_SIZE 64
 
 #endif
@@ -252,7 +252,7 @@ size_t count_if(InputIterator first, InputIterator last, UnaryOps op) {
 }
 
 template <class InputIterator, class T>
-InputIterator find(InputIterator first, InputIterator last, const T &x) {
+InputIterator __find(InputIterator first, InputIterator last, const T &x, __non_segmented_tag) {
     while(first != last) {
         if(*first == x) {
             return first;
@@ -262,6 +262,38 @@ InputIterator find(InputIterator first, InputIterator last, const T &x) {
     return last;
 }
 
+// Searches each segment as a raw pointer range and composes the hit back into an iterator.
+template <class SegIter, class T>
+SegIter __find(SegIter first, SegIter last, const T &x, __segmented_tag) {
+    typedef __segmented_iterator_traits<SegIter> traits;
+    typedef typename traits::local_iterator local_iterator;
+    typename traits::segment_iterator sfirst = traits::segment(first);
+    typename traits::segment_iterator slast = traits::segment(last);
+    if(sfirst == slast) {
+        local_iterator end = traits::local(last);
+        local_iterator pos = __find(traits::local(first), end, x, __non_segmented_tag());
+        return pos == end ? last : traits::compose(sfirst, pos);
+    }
+    local_iterator pos = __find(traits::local(first), traits::end(sfirst), x, __non_segmented_tag());
+    if(pos != traits::end(sfirst)) {
+        return traits::compose(sfirst, pos);
+    }
+    for(++sfirst; sfirst != slast; ++sfirst) {
+        pos = __find(traits::begin(sfirst), traits::end(sfirst), x, __non_segmented_tag());
+        if(pos != traits::end(sfirst)) {
+            return traits::compose(sfirst, pos);
+        }
+    }
+    local_iterator end = traits::local(last);
+    pos = __find(traits::begin(slast), end, x, __non_segmented_tag());
+    return pos == end ? last : traits::compose(slast, pos);
+}
+
+template <class InputIterator, class T>
+InputIterator find(InputIterator first, InputIterator last, const T &x) {
+    return __find(first, last, x, __segmented_category(first));
+}
+
 template < class InputIterator, class UnaryOps>
 InputIterator find_if(InputIterator first, InputIterator last, UnaryOps op) {
     while(first != last) {
@@ -381,13 +413,36 @@ InputIterator1 find_first_of(InputIterator1 first, InputIterator1 last, InputIte
 }
 
 template <class InputIterator, class UnaryOps>
-void for_each(InputIterator first, InputIterator last, UnaryOps op) {
+void __for_each(InputIterator first, InputIterator last, UnaryOps &op, __non_segmented_tag) {
     while(first != last) {
         op(*first);
         ++first;
     }
 }
 
+// Segment by segment.  op is passed by reference across segments, so a
+// stateful function object is not reset at segment boundaries.
+template <class SegIter, class UnaryOps>
+void __for_each(SegIter first, SegIter last, UnaryOps &op, __segmented_tag) {
+    typedef __segmented_iterator_traits<SegIter> traits;
+    typename traits::segment_iterator sfirst = traits::segment(first);
+    typename traits::segment_iterator slast = traits::segment(last);
+    if(sfirst == slast) {
+        __for_each(traits::local(first), traits::local(last), op, __non_segmented_tag());
+        return;
+    }
+    __for_each(traits::local(first), traits::end(sfirst), op, __non_segmented_tag());
+    for(++sfirst; sfirst != slast; ++sfirst) {
+        __for_each(traits::begin(sfirst), traits::end(sfirst), op, __non_segmented_tag());
+    }
+    __for_each(traits::begin(slast), traits::local(last), op, __non_segmented_tag());
+}
+
+template <class InputIterator, class UnaryOps>
+void for_each(InputIterator first, InputIterator last, UnaryOps op) {
+    __for_each(first, last, op, __segmented_category(first));
+}
+
 template <class InputIterator, class Ops>
 void generate(InputIterator first, InputIterator last, Ops op) {
     while(first != last) {
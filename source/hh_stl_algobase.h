@@ -118,13 +118,35 @@ bool equal(Iter1 first, Iter1 last, Iter2 begin, BinaryOps op) {
 }
 
 template <class InputIterator, class T>
-void fill(InputIterator first, InputIterator last, const T &val) {
+void __fill(InputIterator first, InputIterator last, const T &val, __non_segmented_tag) {
     while(first != last) {
         *first = val;
         ++first;
     }
 }
 
+// Fills segment by segment, each one a raw pointer range.
+template <class SegIter, class T>
+void __fill(SegIter first, SegIter last, const T &val, __segmented_tag) {
+    typedef __segmented_iterator_traits<SegIter> traits;
+    typename traits::segment_iterator sfirst = traits::segment(first);
+    typename traits::segment_iterator slast = traits::segment(last);
+    if(sfirst == slast) {
+        __fill(traits::local(first), traits::local(last), val, __non_segmented_tag());
+        return;
+    }
+    __fill(traits::local(first), traits::end(sfirst), val, __non_segmented_tag());
+    for(++sfirst; sfirst != slast; ++sfirst) {
+        __fill(traits::begin(sfirst), traits::end(sfirst), val, __non_segmented_tag());
+    }
+    __fill(traits::begin(slast), traits::local(last), val, __non_segmented_tag());
+}
+
+template <class InputIterator, class T>
+void fill(InputIterator first, InputIterator last, const T &val) {
+    __fill(first, last, val, __segmented_category(first));
+}
+
 template <class InputIterator, class Interge, class T>
 void fill_n(InputIterator begin, Interge n, const T &val) {
     while(n) {
@@ -269,10 +291,72 @@ T* __copy_dispatch(const T *first, const T *last, T *dest) {
     return __copy_t(first, last, dest, type());
 }
 
+template <class Iter1, class Iter2>
+Iter2 copy(Iter1 first, Iter1 last, Iter2 dest);
+
+template <class Iter1, class Iter2>
+Iter2 __copy_segmented(Iter1 first, Iter1 last, Iter2 dest, __non_segmented_tag, __non_segmented_tag) {
+    return __copy_dispatch(first, last, dest);
+}
+
+// Segmented source: copy from each segment as a raw pointer range; a segmented
+// destination is split again by the overload below.  With raw pointers at both
+// ends and trivially assignable elements each piece is one memmove.
+template <class Iter1, class Iter2, class Tag>
+Iter2 __copy_segmented(Iter1 first, Iter1 last, Iter2 dest, __segmented_tag, Tag) {
+    typedef __segmented_iterator_traits<Iter1> traits;
+    typename traits::segment_iterator sfirst = traits::segment(first);
+    typename traits::segment_iterator slast = traits::segment(last);
+    if(sfirst == slast) {
+        return hh_std::copy(traits::local(first), traits::local(last), dest);
+    }
+    dest = hh_std::copy(traits::local(first), traits::end(sfirst), dest);
+    for(++sfirst; sfirst != slast; ++sfirst) {
+        dest = hh_std::copy(traits::begin(sfirst), traits::end(sfirst), dest);
+    }
+    return hh_std::copy(traits::begin(slast), traits::local(last), dest);
+}
+
+template <class Iter1, class Iter2>
+Iter2 __copy_to_segmented(Iter1 first, Iter1 last, Iter2 dest, input_iterator_tag) {
+    return __copy_dispatch(first, last, dest);
+}
+
+// Segmented destination, random access source: cut the source into chunks that
+// fit the room left in each destination segment and copy each into raw pointers.
+template <class Iter1, class Iter2>
+Iter2 __copy_to_segmented(Iter1 first, Iter1 last, Iter2 dest, random_access_iterator_tag) {
+    typedef __segmented_iterator_traits<Iter2> traits;
+    typedef typename iterator_traits<Iter1>::difference_type distance;
+    distance n = last - first;
+    if(n == 0) {
+        return dest;
+    }
+    typename traits::segment_iterator s = traits::segment(dest);
+    typename traits::local_iterator l = traits::local(dest);
+    while(true) {
+        distance room = traits::end(s) - l;
+        distance len = n < room ? n : room;
+        l = hh_std::copy(first, first + len, l);
+        first += len;
+        n -= len;
+        if(n == 0) {
+            return traits::compose(s, l);
+        }
+        ++s;
+        l = traits::begin(s);
+    }
+}
+
+template <class Iter1, class Iter2>
+Iter2 __copy_segmented(Iter1 first, Iter1 last, Iter2 dest, __non_segmented_tag, __segmented_tag) {
+    return __copy_to_segmented(first, last, dest, category_type(first));
+}
+
 template <class Iter1, class Iter2>
 Iter2 copy(Iter1 first, Iter1 last, Iter2 dest) {
     //typedef typename hh_std::__type_traits <typename Iter2::value_type>::has_trivial_assignment_operator type;
-    return __copy_dispatch(first, last, dest);
+    return __copy_segmented(first, last, dest, __segmented_category(first), __segmented_category(dest));
 }
 
 template <>
@@ -6,36 +6,76 @@
 #   define __THROW_BAD_ALLOC throw bad_alloc
 #elif !defined(__THROW_BAD_ALLOC)
 #   include <iostream>
-#   define __THROW_BAD_ALLOC std::cerr<<"out of memory"<<std::endl;exit(1);
+#   define __THROW_BAD_ALLOC { std::cerr<<"out of memory"<<std::endl;exit(1); }
+#endif
+
+#ifndef __STL_NO_ALLOC_STATS
+#   define __ALLOC_STAT(expr) expr
+#else
+#   define __ALLOC_STAT(expr)
 #endif
 
 #include <cstdio>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include "hh_type_traits.h"
 
 namespace hh_std {
 
+struct __malloc_alloc_stats {
+    size_t allocate_count;
+    size_t deallocate_count;
+    size_t reallocate_count;
+    size_t bytes_in_use;
+    size_t high_water;
+    size_t oom_count;
+};
+
 template <int inst>
 class __malloc_alloc_template {
 private:
     static void *oom_alloc(size_t);
     static void *oom_realloc(void*, size_t);
     static void  (*__malloc_alloc_oom_handler)();
+
+    static std::atomic<size_t> allocate_count;
+    static std::atomic<size_t> deallocate_count;
+    static std::atomic<size_t> reallocate_count;
+    static std::atomic<size_t> bytes_in_use;
+    static std::atomic<size_t> high_water;
+    static std::atomic<size_t> oom_count;
+
+    static void record_grow(size_t n) {
+        size_t used = bytes_in_use.fetch_add(n, std::memory_order_relaxed) + n;
+        size_t peak = high_water.load(std::memory_order_relaxed);
+        while(used > peak && !high_water.compare_exchange_weak(peak, used, std::memory_order_relaxed)) { }
+    }
 public:
     static void* allocate(size_t n) {
         void *result = malloc(n);
         if(result == 0) result = oom_alloc(n);
+        __ALLOC_STAT(allocate_count.fetch_add(1, std::memory_order_relaxed));
+        __ALLOC_STAT(record_grow(n));
         return result;
     }
 
     static void* reallocate(void *p, size_t n, size_t new_sz) {
         void *result = realloc(p, new_sz);
         if(result == 0) result = oom_realloc(p, new_sz);
+        __ALLOC_STAT(reallocate_count.fetch_add(1, std::memory_order_relaxed));
+        __ALLOC_STAT(bytes_in_use.fetch_sub(n, std::memory_order_relaxed));
+        __ALLOC_STAT(record_grow(new_sz));
         return result;
     }
 
     static void deallocate(void *p, size_t n) {
         free(p);
+        __ALLOC_STAT(deallocate_count.fetch_add(1, std::memory_order_relaxed));
+        __ALLOC_STAT(bytes_in_use.fetch_sub(n, std::memory_order_relaxed));
     }
 
     static void (*set_oom_handler(void (*f)()))() {
@@ -43,10 +83,41 @@ public:
         __malloc_alloc_oom_handler = f;
         return old;
     }
+
+    static __malloc_alloc_stats get_stats() {
+        __malloc_alloc_stats result;
+        result.allocate_count = allocate_count.load(std::memory_order_relaxed);
+        result.deallocate_count = deallocate_count.load(std::memory_order_relaxed);
+        result.reallocate_count = reallocate_count.load(std::memory_order_relaxed);
+        result.bytes_in_use = bytes_in_use.load(std::memory_order_relaxed);
+        result.high_water = high_water.load(std::memory_order_relaxed);
+        result.oom_count = oom_count.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    static void dump_stats(FILE *out = stderr) {
+        __malloc_alloc_stats st = get_stats();
+        fprintf(out, "malloc_alloc: allocate %zu deallocate %zu reallocate %zu\n",
+                st.allocate_count, st.deallocate_count, st.reallocate_count);
+        fprintf(out, "malloc_alloc: in use %zu bytes, high water %zu bytes, oom handler runs %zu\n",
+                st.bytes_in_use, st.high_water, st.oom_count);
+    }
 };
 
 template <int inst>
 void (*__malloc_alloc_template<inst>::__malloc_alloc_oom_handler)() = 0;
+template <int inst>
+std::atomic<size_t> __malloc_alloc_template<inst>::allocate_count(0);
+template <int inst>
+std::atomic<size_t> __malloc_alloc_template<inst>::deallocate_count(0);
+template <int inst>
+std::atomic<size_t> __malloc_alloc_template<inst>::reallocate_count(0);
+template <int inst>
+std::atomic<size_t> __malloc_alloc_template<inst>::bytes_in_use(0);
+template <int inst>
+std::atomic<size_t> __malloc_alloc_template<inst>::high_water(0);
+template <int inst>
+std::atomic<size_t> __malloc_alloc_template<inst>::oom_count(0);
 
 template <int inst>
 void * __malloc_alloc_template<inst>::oom_alloc(size_t n) {
@@ -55,6 +126,7 @@ void * __malloc_alloc_template<inst>::oom_alloc(size_t n) {
     while(true) {
         my_handler = __malloc_alloc_oom_handler;
         if (my_handler == 0) __THROW_BAD_ALLOC;
+        __ALLOC_STAT(oom_count.fetch_add(1, std::memory_order_relaxed));
         my_handler();
         result = malloc(n);
         if(result != 0)
@@ -69,6 +141,7 @@ void *__malloc_alloc_template<inst>::oom_realloc(void *p, size_t sz) {
     while(true) {
         myhandler  = __malloc_alloc_oom_handler;
         if(myhandler == 0) __THROW_BAD_ALLOC;
+        __ALLOC_STAT(oom_count.fetch_add(1, std::memory_order_relaxed));
         myhandler();
         result = realloc(p, sz);
         if(result != 0)
@@ -81,6 +154,239 @@ typedef __malloc_alloc_template<0> malloc_alloc;
 enum {__ALIGN = 8};
 enum {__MAX_BYTES = 128};
 enum {__NFREELISTS = __MAX_BYTES / __ALIGN};
+enum {__HEAP_HISTORY = 32};
+
+enum {__SLAB_SIZE = 64 * 1024};
+enum {__SLAB_MAX_BYTES = 8192};
+enum {__SLAB_NCLASSES = 12};
+enum {__SLAB_HEADER = 128};
+enum {__SLAB_WORD_BITS = sizeof(size_t) * 8};
+enum {__SLAB_BITMAP_WORDS = ((__SLAB_SIZE - __SLAB_HEADER) / 192 + __SLAB_WORD_BITS - 1) / __SLAB_WORD_BITS};
+
+inline size_t __slab_first_bit(size_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll((unsigned long long)word);
+#else
+    size_t bit = 0;
+    while((word & 1) == 0) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+struct __slab_alloc_stats {
+    size_t allocate_count[__SLAB_NCLASSES];
+    size_t deallocate_count[__SLAB_NCLASSES];
+    size_t slab_count[__SLAB_NCLASSES];
+    size_t bytes_in_use;
+    size_t released_bytes;
+};
+
+template <int inst>
+class __slab_alloc_template {
+private:
+    struct slab {
+        slab *prev;
+        slab *next;
+        size_t obj_size;
+        size_t capacity;
+        size_t free_count;
+        size_t index;
+        size_t bitmap[__SLAB_BITMAP_WORDS];
+    };
+
+    static size_t SLAB_INDEX(size_t n) {
+        size_t k = 8;
+        while((size_t(1) << k) < n) {
+            ++k;
+        }
+        return 2 * (k - 8) + (n > (size_t(3) << (k - 2)) ? 1 : 0);
+    }
+
+    static size_t SLAB_CLASS_SIZE(size_t index) {
+        size_t k = index / 2 + 8;
+        return index % 2 ? size_t(1) << k : size_t(3) << (k - 2);
+    }
+
+    static slab *partial[__SLAB_NCLASSES];
+    static slab *empty[__SLAB_NCLASSES];
+    static __slab_alloc_stats stats;
+
+    static char *slab_data(slab *s) {
+        return (char*)s + __SLAB_HEADER;
+    }
+    static slab *slab_of(void *p) {
+        return (slab*)((size_t)p & ~(size_t)(__SLAB_SIZE - 1));
+    }
+    static void link(slab *s) {
+        s->prev = 0;
+        s->next = partial[s->index];
+        if(s->next) s->next->prev = s;
+        partial[s->index] = s;
+    }
+    static void unlink(slab *s) {
+        if(s->prev) {
+            s->prev->next = s->next;
+        } else {
+            partial[s->index] = s->next;
+        }
+        if(s->next) s->next->prev = s->prev;
+        s->prev = s->next = 0;
+    }
+    static slab *new_slab(size_t index);
+    static void free_slab(slab *s);
+
+public:
+    static size_t class_size(size_t n) {
+        return SLAB_CLASS_SIZE(SLAB_INDEX(n));
+    }
+    static void *allocate(size_t n);
+    static void deallocate(void *p, size_t n);
+    static size_t trim();
+
+    static __slab_alloc_stats get_stats() {
+        return stats;
+    }
+    static void dump_stats(FILE *out = stderr);
+};
+
+template <int inst>
+typename __slab_alloc_template<inst>::slab *__slab_alloc_template<inst>::partial[__SLAB_NCLASSES] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+template <int inst>
+typename __slab_alloc_template<inst>::slab *__slab_alloc_template<inst>::empty[__SLAB_NCLASSES] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+template <int inst>
+__slab_alloc_stats __slab_alloc_template<inst>::stats;
+
+template <int inst>
+typename __slab_alloc_template<inst>::slab *__slab_alloc_template<inst>::new_slab(size_t index) {
+    void *p;
+#ifdef _WIN32
+    p = _aligned_malloc(__SLAB_SIZE, __SLAB_SIZE);
+#else
+    if(posix_memalign(&p, __SLAB_SIZE, __SLAB_SIZE) != 0) p = 0;
+#endif
+    if(p == 0) __THROW_BAD_ALLOC;
+    slab *s = (slab*)p;
+    s->prev = s->next = 0;
+    s->index = index;
+    s->obj_size = SLAB_CLASS_SIZE(index);
+    s->capacity = (__SLAB_SIZE - __SLAB_HEADER) / s->obj_size;
+    s->free_count = s->capacity;
+    for(size_t w = 0; w < __SLAB_BITMAP_WORDS; ++w) {
+        size_t first = w * __SLAB_WORD_BITS;
+        if(first + __SLAB_WORD_BITS <= s->capacity) {
+            s->bitmap[w] = ~size_t(0);
+        } else if(first < s->capacity) {
+            s->bitmap[w] = (size_t(1) << (s->capacity - first)) - 1;
+        } else {
+            s->bitmap[w] = 0;
+        }
+    }
+    __ALLOC_STAT(++stats.slab_count[index]);
+    return s;
+}
+
+template <int inst>
+void __slab_alloc_template<inst>::free_slab(slab *s) {
+    __ALLOC_STAT(--stats.slab_count[s->index]);
+    __ALLOC_STAT(stats.released_bytes += __SLAB_SIZE);
+#ifdef _WIN32
+    _aligned_free(s);
+#else
+    free(s);
+#endif
+}
+
+template <int inst>
+void *__slab_alloc_template<inst>::allocate(size_t n) {
+    size_t index = SLAB_INDEX(n);
+    slab *s = partial[index];
+    if(s == 0) {
+        s = empty[index];
+        if(s) {
+            empty[index] = 0;
+        } else {
+            s = new_slab(index);
+        }
+        link(s);
+    }
+    size_t w = 0;
+    while(s->bitmap[w] == 0) {
+        ++w;
+    }
+    size_t bit = __slab_first_bit(s->bitmap[w]);
+    s->bitmap[w] &= s->bitmap[w] - 1;
+    if(--s->free_count == 0) {
+        unlink(s);
+    }
+    __ALLOC_STAT(++stats.allocate_count[index]);
+    __ALLOC_STAT(stats.bytes_in_use += s->obj_size);
+    return slab_data(s) + (w * __SLAB_WORD_BITS + bit) * s->obj_size;
+}
+
+template <int inst>
+void __slab_alloc_template<inst>::deallocate(void *p, size_t) {
+    slab *s = slab_of(p);
+    size_t pos = ((char*)p - slab_data(s)) / s->obj_size;
+    s->bitmap[pos / __SLAB_WORD_BITS] |= size_t(1) << (pos % __SLAB_WORD_BITS);
+    __ALLOC_STAT(++stats.deallocate_count[s->index]);
+    __ALLOC_STAT(stats.bytes_in_use -= s->obj_size);
+    if(s->free_count++ == 0) {
+        link(s);
+    }
+    if(s->free_count == s->capacity) {
+        unlink(s);
+        if(empty[s->index] == 0) {
+            empty[s->index] = s;
+        } else {
+            free_slab(s);
+        }
+    }
+}
+
+template <int inst>
+size_t __slab_alloc_template<inst>::trim() {
+    size_t released = 0;
+    for(size_t i = 0; i < __SLAB_NCLASSES; ++i) {
+        if(empty[i]) {
+            free_slab(empty[i]);
+            empty[i] = 0;
+            released += __SLAB_SIZE;
+        }
+    }
+    return released;
+}
+
+template <int inst>
+void __slab_alloc_template<inst>::dump_stats(FILE *out) {
+    fprintf(out, "slab_alloc: in use %zu bytes, released %zu bytes\n", stats.bytes_in_use, stats.released_bytes);
+    for(size_t i = 0; i < __SLAB_NCLASSES; ++i) {
+        if(stats.allocate_count[i] || stats.slab_count[i]) {
+            fprintf(out, "  %4zu bytes: allocate %zu deallocate %zu slabs %zu\n", SLAB_CLASS_SIZE(i),
+                    stats.allocate_count[i], stats.deallocate_count[i], stats.slab_count[i]);
+        }
+    }
+}
+
+
+struct __default_alloc_stats {
+    size_t allocate_count[__NFREELISTS];
+    size_t deallocate_count[__NFREELISTS];
+    size_t free_list_length[__NFREELISTS];
+    size_t chunk_bytes;
+    size_t heap_size;
+    size_t heap_total;
+    size_t heap_growth[__HEAP_HISTORY];
+    size_t heap_growth_count;
+    size_t bytes_in_use;
+    size_t high_water;
+    size_t oom_count;
+    size_t chunk_count;
+    size_t trim_count;
+    size_t released_bytes;
+};
 
 template <int inst>
 class __default_alloc_template {
@@ -98,19 +404,96 @@ private:
         return (n - 1) / __ALIGN;
     }
 
+    struct chunk_header {
+        chunk_header *next;
+        size_t size;
+        // Set when the chunk came from malloc_alloc's out-of-memory path, so
+        // trim() hands it back through malloc_alloc and its stats stay even.
+        bool from_malloc_alloc;
+    };
+
+    struct chunk_span {
+        char *begin;
+        char *end;
+        size_t free_bytes;
+        chunk_header *header;
+
+        // Keeps std::sort from seeing both std::swap and hh_std::swap.
+        friend void swap(chunk_span &a, chunk_span &b) {
+            chunk_span tmp = a;
+            a = b;
+            b = tmp;
+        }
+    };
+
     static obj* volatile free_list[__NFREELISTS];
     static void *refill(size_t);
     static char *chunk_alloc(size_t n, int &objs);
     static char *start_free;
     static char *end_free;
     static size_t heap_size;
+    static chunk_header *chunk_list;
+    static size_t chunk_bytes;
+    static size_t in_use;
+    static size_t trim_threshold;
+    static size_t trim_floor;
+    static __default_alloc_stats stats;
+
+    static void record_allocate(size_t index) {
+        ++stats.allocate_count[index];
+        if(in_use > stats.high_water) {
+            stats.high_water = in_use;
+        }
+    }
+
+    static chunk_span *find_span(chunk_span *spans, size_t n, char *p) {
+        chunk_span *first = spans, *last = spans + n;
+        while(first != last) {
+            chunk_span *mid = first + (last - first) / 2;
+            if(p < mid->begin) {
+                last = mid;
+            } else if(p >= mid->end) {
+                first = mid + 1;
+            } else {
+                return mid;
+            }
+        }
+        return 0;
+    }
 
 public:
     static void *allocate(size_t n);
     static void *reallocate(void *p, size_t n, size_t sz);
     static void deallocate(void *p, size_t n);
+
+    static size_t trim();
+    static size_t release_unused() {
+        return trim();
+    }
+    static size_t set_trim_threshold(size_t bytes) {
+        size_t old = trim_threshold;
+        trim_threshold = bytes;
+        trim_floor = chunk_bytes - in_use;
+        return old;
+    }
+
+    static __default_alloc_stats get_stats();
+    static void dump_stats(FILE *out = stderr);
 };
 
+template <int inst>
+typename __default_alloc_template<inst>::chunk_header *__default_alloc_template<inst>::chunk_list = 0;
+template <int inst>
+size_t __default_alloc_template<inst>::chunk_bytes = 0;
+template <int inst>
+size_t __default_alloc_template<inst>::in_use = 0;
+template <int inst>
+size_t __default_alloc_template<inst>::trim_threshold = 0;
+template <int inst>
+size_t __default_alloc_template<inst>::trim_floor = 0;
+
+template <int inst>
+__default_alloc_stats __default_alloc_template<inst>::stats;
 template <int inst>
 char *__default_alloc_template<inst>::start_free = 0;
 template <int inst>
@@ -123,6 +506,9 @@ typename __default_alloc_template<inst>::obj* volatile __default_alloc_template<
 template <int inst>
 void *__default_alloc_template<inst>::allocate(size_t n) {
     if(n > __MAX_BYTES) {
+        if(n <= __SLAB_MAX_BYTES) {
+            return __slab_alloc_template<inst>::allocate(n);
+        }
         return malloc_alloc::allocate(n);
     }
     size_t index = FREELIST_INDEX(n);
@@ -133,34 +519,160 @@ void *__default_alloc_template<inst>::allocate(size_t n) {
     } else {
         result = refill(ROUND_UP(n));
     }
+    in_use += ROUND_UP(n);
+    __ALLOC_STAT(record_allocate(index));
     return result;
 }
 
 template <int inst>
 void *__default_alloc_template<inst>::reallocate(void *p, size_t n, size_t sz) {
-    if (sz > __MAX_BYTES) {
+    if (n > __SLAB_MAX_BYTES && sz > __SLAB_MAX_BYTES) {
         return malloc_alloc::reallocate(p, n, sz);
     }
-    if(ROUND_UP(n) == ROUND_UP(sz))
+    if(n <= __MAX_BYTES && sz <= __MAX_BYTES && ROUND_UP(n) == ROUND_UP(sz))
         return p;
-    size_t index = FREELIST_INDEX(sz);
-    void *result;
-    if(free_list[index]) {
-        result = free_list[index];
-        free_list[index] = free_list[index]->next;
-    } else {
-        result = refill(ROUND_UP(sz));
-    }
+    if(n > __MAX_BYTES && sz > __MAX_BYTES && n <= __SLAB_MAX_BYTES && sz <= __SLAB_MAX_BYTES
+       && __slab_alloc_template<inst>::class_size(n) == __slab_alloc_template<inst>::class_size(sz))
+        return p;
+    void *result = allocate(sz);
     size_t copy_sz = n > sz ? sz : n;
     memmove(result, p, copy_sz);
+    deallocate(p, n);
     return result;
 }
 
 template <int inst>
 void __default_alloc_template<inst>::deallocate(void *p, size_t n) {
+    if(n > __MAX_BYTES) {
+        if(n <= __SLAB_MAX_BYTES) {
+            __slab_alloc_template<inst>::deallocate(p, n);
+        } else {
+            malloc_alloc::deallocate(p, n);
+        }
+        return;
+    }
     size_t index = FREELIST_INDEX(n);
     ((obj*)p)->next = free_list[index];
     free_list[index] = (obj*)p;
+    in_use -= ROUND_UP(n);
+    __ALLOC_STAT(++stats.deallocate_count[index]);
+    if(trim_threshold != 0 && chunk_bytes - in_use > trim_floor + trim_threshold) {
+        trim();
+        trim_floor = chunk_bytes - in_use;
+    }
+}
+
+template <int inst>
+size_t __default_alloc_template<inst>::trim() {
+    size_t slab_released = __slab_alloc_template<inst>::trim();
+    size_t n = 0;
+    for(chunk_header *cur = chunk_list; cur; cur = cur->next) {
+        ++n;
+    }
+    if(n == 0) return slab_released;
+    chunk_span *spans = (chunk_span*)malloc(n * sizeof(chunk_span));
+    if(spans == 0) return slab_released;
+    size_t i = 0;
+    for(chunk_header *cur = chunk_list; cur; cur = cur->next, ++i) {
+        spans[i].begin = (char*)(cur + 1);
+        spans[i].end = spans[i].begin + cur->size;
+        spans[i].free_bytes = 0;
+        spans[i].header = cur;
+    }
+    std::sort(spans, spans + n, [](const chunk_span & a, const chunk_span & b) {
+        return a.begin < b.begin;
+    });
+    for(size_t index = 0; index < __NFREELISTS; ++index) {
+        for(obj *cur = free_list[index]; cur; cur = cur->next) {
+            find_span(spans, n, (char*)cur)->free_bytes += (index + 1) * __ALIGN;
+        }
+    }
+    chunk_span *pool = start_free != end_free ? find_span(spans, n, start_free) : 0;
+    if(pool) {
+        pool->free_bytes += end_free - start_free;
+    }
+    size_t released = 0;
+    for(i = 0; i < n; ++i) {
+        if(spans[i].free_bytes == spans[i].header->size) {
+            released += spans[i].header->size;
+        }
+    }
+    if(released != 0) {
+        for(size_t index = 0; index < __NFREELISTS; ++index) {
+            obj *head = 0, **tail = &head;
+            for(obj *cur = free_list[index]; cur; cur = cur->next) {
+                chunk_span *span = find_span(spans, n, (char*)cur);
+                if(span->free_bytes != span->header->size) {
+                    *tail = cur;
+                    tail = &cur->next;
+                }
+            }
+            *tail = 0;
+            free_list[index] = head;
+        }
+        if(pool && pool->free_bytes == pool->header->size) {
+            start_free = end_free = 0;
+        }
+        chunk_header **link = &chunk_list;
+        while(*link) {
+            chunk_header *cur = *link;
+            chunk_span *span = find_span(spans, n, (char*)(cur + 1));
+            if(span->free_bytes == cur->size) {
+                *link = cur->next;
+                chunk_bytes -= cur->size;
+                __ALLOC_STAT(--stats.chunk_count);
+                if(cur->from_malloc_alloc) {
+                    malloc_alloc::deallocate(cur, sizeof(chunk_header) + cur->size);
+                } else {
+                    free(cur);
+                }
+            } else {
+                link = &cur->next;
+            }
+        }
+        __ALLOC_STAT(stats.released_bytes += released);
+    }
+    __ALLOC_STAT(++stats.trim_count);
+    free(spans);
+    return released + slab_released;
+}
+
+template <int inst>
+__default_alloc_stats __default_alloc_template<inst>::get_stats() {
+    __default_alloc_stats result = stats;
+    for(size_t i = 0; i < __NFREELISTS; ++i) {
+        size_t len = 0;
+        for(obj *cur = free_list[i]; cur; cur = cur->next) {
+            ++len;
+        }
+        result.free_list_length[i] = len;
+    }
+    result.heap_size = heap_size;
+    result.bytes_in_use = in_use;
+    return result;
+}
+
+template <int inst>
+void __default_alloc_template<inst>::dump_stats(FILE *out) {
+    __default_alloc_stats st = get_stats();
+    fprintf(out, "default_alloc: in use %zu bytes, high water %zu bytes, chunk bytes %zu, oom %zu\n",
+            st.bytes_in_use, st.high_water, st.chunk_bytes, st.oom_count);
+    fprintf(out, "default_alloc: %zu live chunks, %zu trims released %zu bytes\n",
+            st.chunk_count, st.trim_count, st.released_bytes);
+    fprintf(out, "default_alloc: heap_size %zu, heap total %zu, %zu chunks:",
+            st.heap_size, st.heap_total, st.heap_growth_count);
+    size_t first = st.heap_growth_count > __HEAP_HISTORY ? st.heap_growth_count - __HEAP_HISTORY : 0;
+    for(size_t i = first; i < st.heap_growth_count; ++i) {
+        fprintf(out, " %zu", st.heap_growth[i % __HEAP_HISTORY]);
+    }
+    fprintf(out, "\n");
+    for(size_t i = 0; i < __NFREELISTS; ++i) {
+        if(st.allocate_count[i] || st.free_list_length[i]) {
+            fprintf(out, "  %4zu bytes: allocate %zu deallocate %zu free %zu\n", (i + 1) * __ALIGN,
+                    st.allocate_count[i], st.deallocate_count[i], st.free_list_length[i]);
+        }
+    }
+    __slab_alloc_template<inst>::dump_stats(out);
 }
 
 template <int inst>
@@ -169,11 +681,12 @@ void *__default_alloc_template<inst>::refill(size_t n) {
     void *result = chunk_alloc(n, objs);
     if (objs > 1) {
         size_t index = FREELIST_INDEX(n);
-        obj* cur_data = free_list[index] = (obj*)result + n;
+        obj* cur_data = free_list[index] = (obj*)((char*)result + n);
         obj* next_data;
-        while(objs > 1) {
-            cur_data->next = next_data;
+        while(objs > 2) {
             next_data = (obj*)((char*)cur_data + n);
+            cur_data->next = next_data;
+            cur_data = next_data;
             objs--;
         }
         cur_data->next = 0;
@@ -189,12 +702,14 @@ char *__default_alloc_template<inst>::chunk_alloc(size_t n, int &objs) {
     if (total_left >= total_require) {
         result = start_free;
         start_free += total_require;
+        __ALLOC_STAT(stats.chunk_bytes += total_require);
         return result;
     } else if(total_left >= n) {
         objs = total_left / n;
         total_require = n * objs;
         result = start_free;
         start_free += total_require;
+        __ALLOC_STAT(stats.chunk_bytes += total_require);
         return result;
     } else {
         size_t index;
@@ -204,8 +719,9 @@ char *__default_alloc_template<inst>::chunk_alloc(size_t n, int &objs) {
             free_list[index] = (obj*)start_free;
         }
         size_t malloc_size = 2 * total_require + heap_size;
-        result = (char*)malloc(malloc_size);
-        if (result == 0) {
+        chunk_header *chunk = (chunk_header*)malloc(sizeof(chunk_header) + malloc_size);
+        if (chunk == 0) {
+            __ALLOC_STAT(++stats.oom_count);
             for(index = FREELIST_INDEX(n); index < __NFREELISTS; index++) {
                 if(free_list[index] != 0) {
                     start_free = (char*)free_list[index];
@@ -215,21 +731,457 @@ char *__default_alloc_template<inst>::chunk_alloc(size_t n, int &objs) {
                 }
             }
             start_free = end_free = 0;
+            chunk = (chunk_header*)malloc_alloc::allocate(sizeof(chunk_header) + malloc_size);
+            chunk->from_malloc_alloc = true;
+        } else {
+            chunk->from_malloc_alloc = false;
+        }
+        chunk->size = malloc_size;
+        chunk->next = chunk_list;
+        chunk_list = chunk;
+        chunk_bytes += malloc_size;
+        start_free = (char*)(chunk + 1);
+        end_free = start_free + malloc_size;
+        heap_size = malloc_size;
+        __ALLOC_STAT(++stats.chunk_count);
+        __ALLOC_STAT(stats.heap_total += malloc_size);
+        __ALLOC_STAT(stats.heap_growth[stats.heap_growth_count++ % __HEAP_HISTORY] = malloc_size);
+        return chunk_alloc(n, objs);
+    }
+}
+
+enum {__TC_MAX_BATCH = 32};
+enum {__TC_BATCH_BYTES = 4096};
+
+template <int inst>
+class __thread_cache_alloc_template {
+private:
+    union obj {
+        obj *next;
+        char data[1];
+    };
+
+    struct thread_cache {
+        obj *free_list[__NFREELISTS];
+        size_t length[__NFREELISTS];
+
+        thread_cache() {
+            for(size_t i = 0; i < __NFREELISTS; ++i) {
+                free_list[i] = 0;
+                length[i] = 0;
+            }
+        }
+        ~thread_cache() {
+            for(size_t i = 0; i < __NFREELISTS; ++i) {
+                if(free_list[i]) {
+                    release_to_depot(i, free_list[i]);
+                }
+            }
+            torn_down() = true;
+        }
+    };
+
+    static size_t ROUND_UP(size_t n) {
+        return (n + __ALIGN - 1) / __ALIGN * __ALIGN;
+    }
+
+    static size_t FREELIST_INDEX(size_t n) {
+        return (n - 1) / __ALIGN;
+    }
+
+    static size_t BATCH_SIZE(size_t index) {
+        size_t objs = __TC_BATCH_BYTES / ((index + 1) * __ALIGN);
+        return objs > size_t(__TC_MAX_BATCH) ? size_t(__TC_MAX_BATCH) : objs;
+    }
+
+    // Other thread_local objects may still allocate or free from their
+    // destructors after this thread's cache is gone.  The flag is a plain
+    // bool with no destructor, so it stays readable through thread exit and
+    // sends those late calls straight to the depot.
+    static bool &torn_down() {
+        static thread_local bool flag = false;
+        return flag;
+    }
+    static thread_cache *local_cache() {
+        if(torn_down()) {
+            return 0;
+        }
+        static thread_local thread_cache cache;
+        return &cache;
+    }
+
+    static std::mutex depot_lock;
+    static obj *depot_list[__NFREELISTS];
+    static char *start_free;
+    static char *end_free;
+    static size_t heap_size;
+
+    static obj *fetch_from_depot(size_t index, size_t &objs);
+    static void release_to_depot(size_t index, obj *first);
+    static char *chunk_alloc(size_t n, int &objs);
+
+public:
+    static void *allocate(size_t n);
+    static void *reallocate(void *p, size_t n, size_t sz);
+    static void deallocate(void *p, size_t n);
+};
+
+template <int inst>
+std::mutex __thread_cache_alloc_template<inst>::depot_lock;
+template <int inst>
+typename __thread_cache_alloc_template<inst>::obj *__thread_cache_alloc_template<inst>::depot_list[__NFREELISTS] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+template <int inst>
+char *__thread_cache_alloc_template<inst>::start_free = 0;
+template <int inst>
+char *__thread_cache_alloc_template<inst>::end_free = 0;
+template <int inst>
+size_t __thread_cache_alloc_template<inst>::heap_size = 0;
+
+template <int inst>
+void *__thread_cache_alloc_template<inst>::allocate(size_t n) {
+    if(n > __MAX_BYTES) {
+        return malloc_alloc::allocate(n);
+    }
+    size_t index = FREELIST_INDEX(n);
+    thread_cache *cache = local_cache();
+    if(cache == 0) {
+        size_t objs = 1;
+        return fetch_from_depot(index, objs);
+    }
+    obj *result = cache->free_list[index];
+    if(result == 0) {
+        size_t objs = BATCH_SIZE(index);
+        result = fetch_from_depot(index, objs);
+        cache->length[index] = objs;
+    }
+    cache->free_list[index] = result->next;
+    --cache->length[index];
+    return result;
+}
+
+template <int inst>
+void *__thread_cache_alloc_template<inst>::reallocate(void *p, size_t n, size_t sz) {
+    if (n > __MAX_BYTES && sz > __MAX_BYTES) {
+        return malloc_alloc::reallocate(p, n, sz);
+    }
+    if(ROUND_UP(n) == ROUND_UP(sz))
+        return p;
+    void *result = allocate(sz);
+    size_t copy_sz = n > sz ? sz : n;
+    memmove(result, p, copy_sz);
+    deallocate(p, n);
+    return result;
+}
+
+template <int inst>
+void __thread_cache_alloc_template<inst>::deallocate(void *p, size_t n) {
+    if(n > __MAX_BYTES) {
+        malloc_alloc::deallocate(p, n);
+        return;
+    }
+    size_t index = FREELIST_INDEX(n);
+    thread_cache *cache = local_cache();
+    if(cache == 0) {
+        ((obj*)p)->next = 0;
+        release_to_depot(index, (obj*)p);
+        return;
+    }
+    ((obj*)p)->next = cache->free_list[index];
+    cache->free_list[index] = (obj*)p;
+    size_t batch = BATCH_SIZE(index);
+    if(++cache->length[index] >= 2 * batch) {
+        obj *first = cache->free_list[index], *last = first;
+        for(size_t i = 1; i < batch; ++i) {
+            last = last->next;
+        }
+        cache->free_list[index] = last->next;
+        cache->length[index] -= batch;
+        last->next = 0;
+        release_to_depot(index, first);
+    }
+}
+
+template <int inst>
+typename __thread_cache_alloc_template<inst>::obj *__thread_cache_alloc_template<inst>::fetch_from_depot(size_t index, size_t &objs) {
+    std::lock_guard<std::mutex> guard(depot_lock);
+    obj *result = depot_list[index];
+    if(result) {
+        obj *last = result;
+        size_t got = 1;
+        while(got < objs && last->next) {
+            last = last->next;
+            ++got;
+        }
+        depot_list[index] = last->next;
+        last->next = 0;
+        objs = got;
+        return result;
+    }
+    size_t n = (index + 1) * __ALIGN;
+    int chunk_objs = (int)objs;
+    char *chunk = chunk_alloc(n, chunk_objs);
+    objs = chunk_objs;
+    obj *cur = (obj*)chunk;
+    for(int i = 1; i < chunk_objs; ++i) {
+        cur->next = (obj*)((char*)cur + n);
+        cur = cur->next;
+    }
+    cur->next = 0;
+    return (obj*)chunk;
+}
+
+template <int inst>
+void __thread_cache_alloc_template<inst>::release_to_depot(size_t index, obj *first) {
+    obj *last = first;
+    while(last->next) {
+        last = last->next;
+    }
+    std::lock_guard<std::mutex> guard(depot_lock);
+    last->next = depot_list[index];
+    depot_list[index] = first;
+}
+
+template <int inst>
+char *__thread_cache_alloc_template<inst>::chunk_alloc(size_t n, int &objs) {
+    size_t total_require = n * objs;
+    size_t total_left = end_free - start_free;
+    char *result;
+    if (total_left >= total_require) {
+        result = start_free;
+        start_free += total_require;
+        return result;
+    } else if(total_left >= n) {
+        objs = total_left / n;
+        total_require = n * objs;
+        result = start_free;
+        start_free += total_require;
+        return result;
+    } else {
+        if (total_left > 0) {
+            size_t index = FREELIST_INDEX(total_left);
+            ((obj*)start_free)->next = depot_list[index];
+            depot_list[index] = (obj*)start_free;
+        }
+        size_t malloc_size = 2 * total_require + ROUND_UP(heap_size >> 4);
+        result = (char*)malloc(malloc_size);
+        if (result == 0) {
+            for(size_t index = FREELIST_INDEX(n); index < __NFREELISTS; index++) {
+                if(depot_list[index] != 0) {
+                    start_free = (char*)depot_list[index];
+                    end_free = start_free + (index + 1) * __ALIGN;
+                    depot_list[index] = depot_list[index]->next;
+                    return chunk_alloc(n, objs);
+                }
+            }
+            start_free = end_free = 0;
             result = (char*)malloc_alloc::allocate(malloc_size);
         }
         start_free = result;
         end_free = start_free + malloc_size;
-        heap_size = malloc_size;
+        heap_size += malloc_size;
         return chunk_alloc(n, objs);
     }
 }
 
+typedef __thread_cache_alloc_template<0> mt_alloc;
+
+enum {__ARENA_ALIGN = 16};
+enum {__ARENA_MIN_BLOCK = 4096};
+enum {__ARENA_MAX_BLOCK = 1024 * 1024};
+
+template <int inst>
+class __arena_alloc_template {
+private:
+    // Aligned so that the data after the header starts on __ARENA_ALIGN.
+    struct alignas(__ARENA_ALIGN) block {
+        block *prev;
+        size_t size;
+    };
+
+    static thread_local block *head;
+    static thread_local char *cur;
+    static thread_local char *limit;
+
+    static size_t ROUND_UP(size_t n) {
+        return (n + __ARENA_ALIGN - 1) / __ARENA_ALIGN * __ARENA_ALIGN;
+    }
+
+    static void grow(size_t n) {
+        size_t size = head ? head->size * 2 : __ARENA_MIN_BLOCK;
+        if(size > __ARENA_MAX_BLOCK) size = __ARENA_MAX_BLOCK;
+        if(size < n) size = n;
+        block *b = (block*)malloc_alloc::allocate(sizeof(block) + size);
+        b->prev = head;
+        b->size = size;
+        head = b;
+        cur = (char*)(b + 1);
+        limit = cur + size;
+    }
+
+public:
+    struct mark_type {
+        block *b;
+        char *cur;
+    };
+
+    class scope {
+    private:
+        mark_type m;
+        scope(const scope&);
+        scope &operator= (const scope&);
+    public:
+        scope(): m(mark()) {}
+        ~scope() {
+            rewind(m);
+        }
+    };
+
+    static void *allocate(size_t n) {
+        n = ROUND_UP(n);
+        if(size_t(limit - cur) < n) grow(n);
+        void *result = cur;
+        cur += n;
+        return result;
+    }
+
+    static void *reallocate(void *p, size_t n, size_t sz) {
+        if((char*)p + ROUND_UP(n) == cur && size_t(limit - (char*)p) >= ROUND_UP(sz)) {
+            cur = (char*)p + ROUND_UP(sz);
+            return p;
+        }
+        if(sz <= n) return p;
+        void *result = allocate(sz);
+        memcpy(result, p, n);
+        return result;
+    }
+
+    static void deallocate(void *p, size_t n) {
+        if((char*)p + ROUND_UP(n) == cur) {
+            cur = (char*)p;
+        }
+    }
+
+    static mark_type mark() {
+        mark_type m;
+        m.b = head;
+        m.cur = cur;
+        return m;
+    }
+
+    static void rewind(const mark_type &m) {
+        while(head != m.b) {
+            block *prev = head->prev;
+            malloc_alloc::deallocate(head, sizeof(block) + head->size);
+            head = prev;
+        }
+        cur = m.cur;
+        limit = head ? (char*)(head + 1) + head->size : 0;
+    }
+
+    static void release() {
+        mark_type m;
+        m.b = 0;
+        m.cur = 0;
+        rewind(m);
+    }
+};
+
+template <int inst>
+thread_local typename __arena_alloc_template<inst>::block *__arena_alloc_template<inst>::head = 0;
+template <int inst>
+thread_local char *__arena_alloc_template<inst>::cur = 0;
+template <int inst>
+thread_local char *__arena_alloc_template<inst>::limit = 0;
+
+typedef __arena_alloc_template<0> arena_alloc;
+typedef arena_alloc::scope arena_scope;
+
 #ifdef __USE_MALLOC
 typedef malloc_alloc alloc;
+#elif defined(__STL_THREADS)
+typedef mt_alloc alloc;
 #else
 typedef __default_alloc_template<0> alloc;
 #endif
 
+// An allocator adapter that keeps up to Limit freed blocks for reuse.  The
+// node containers (list, slist, rb_tree, hashtable) each hold their own
+// allocator instance, so giving one node_cache_alloc<alloc> makes it recycle
+// its own nodes: under steady insert/erase churn a node comes back from the
+// cache without a call into Alloc, and it was last touched by this container.
+//
+// Only blocks of the size of the first allocation are cached, which for a
+// node container is its node size; other sizes (hashtable's buckets, list's
+// sort buffer) pass straight through.  Copies start with an empty cache and
+// assignment keeps each side's cache, so the cache never leaves its owner.
+// Like the container, it is not thread safe.
+template <class Alloc = alloc, size_t Limit = 64>
+class node_cache_alloc: private Alloc {
+private:
+    struct obj {
+        obj *next;
+    };
+
+    obj *free_list;
+    size_t count;
+    size_t block;
+
+    Alloc &base() {
+        return *this;
+    }
+
+public:
+    node_cache_alloc(): free_list(0), count(0), block(0) {}
+    explicit node_cache_alloc(const Alloc &a): Alloc(a), free_list(0), count(0), block(0) {}
+    node_cache_alloc(const node_cache_alloc &x): Alloc(x), free_list(0), count(0), block(0) {}
+    node_cache_alloc &operator= (const node_cache_alloc &x) {
+        if(&x != this) {
+            release();
+            base() = x;
+        }
+        return *this;
+    }
+    ~node_cache_alloc() {
+        release();
+    }
+
+    void *allocate(size_t n) {
+        if(block == 0 && n >= sizeof(obj)) {
+            block = n;
+        }
+        if(n == block && free_list) {
+            obj *result = free_list;
+            free_list = result->next;
+            --count;
+            return result;
+        }
+        return base().allocate(n);
+    }
+    void deallocate(void *p, size_t n) {
+        if(n == block && count < Limit) {
+            obj *q = (obj*)p;
+            q->next = free_list;
+            free_list = q;
+            ++count;
+            return;
+        }
+        base().deallocate(p, n);
+    }
+
+    size_t cached() const {
+        return count;
+    }
+    // Returns the cached blocks to Alloc.
+    void release() {
+        while(free_list) {
+            obj *q = free_list;
+            free_list = q->next;
+            base().deallocate(q, block);
+        }
+        count = 0;
+    }
+};
+
 template <class T, class Alloc>
 struct simple_alloc {
     static T *allocate(size_t n) {
@@ -244,7 +1196,114 @@ struct simple_alloc {
     static void deallocate(T *p, size_t n) {
         Alloc::deallocate(p, n * sizeof(T));
     }
+
+    static T *allocate(Alloc &a, size_t n) {
+        return (T*)a.allocate(sizeof(T) * n);
+    }
+    static T *allocate(Alloc &a) {
+        return (T*)a.allocate(sizeof(T));
+    }
+    static void deallocate(Alloc &a, T *p) {
+        a.deallocate(p, sizeof(T));
+    }
+    static void deallocate(Alloc &a, T *p, size_t n) {
+        a.deallocate(p, n * sizeof(T));
+    }
+    static T *reallocate(Alloc &a, T *p, size_t n, size_t new_n) {
+        return (T*)a.reallocate(p, n * sizeof(T), new_n * sizeof(T));
+    }
+};
+
+// Containers keep their allocator instance in this base so that the static
+// allocators above (alloc, malloc_alloc, arena_alloc) take no space.
+template <class Alloc>
+class __alloc_holder: private Alloc {
+public:
+    __alloc_holder() {}
+    explicit __alloc_holder(const Alloc &a): Alloc(a) {}
+
+    Alloc &get_alloc() {
+        return *this;
+    }
+    const Alloc &get_alloc() const {
+        return *this;
+    }
+};
+
+// Specialize for an allocator type to change how container copy, move and
+// swap treat the allocator instance.
+template <class Alloc>
+struct __alloc_traits {
+    typedef __false_type propagate_on_copy_assignment;
+    typedef __true_type propagate_on_move_assignment;
+    typedef __true_type propagate_on_swap;
+    // __true_type when Alloc has reallocate(p, n, new_n), which containers
+    // use to grow trivially relocatable storage without a copy loop.
+    typedef __false_type has_reallocate;
+
+    static Alloc select_on_copy_construction(const Alloc &a) {
+        return a;
+    }
 };
 
+template <int inst>
+struct __alloc_traits<__malloc_alloc_template<inst> > {
+    typedef __false_type propagate_on_copy_assignment;
+    typedef __true_type propagate_on_move_assignment;
+    typedef __true_type propagate_on_swap;
+    typedef __true_type has_reallocate;
+
+    static __malloc_alloc_template<inst> select_on_copy_construction(const __malloc_alloc_template<inst> &a) {
+        return a;
+    }
+};
+
+template <int inst>
+struct __alloc_traits<__default_alloc_template<inst> > {
+    typedef __false_type propagate_on_copy_assignment;
+    typedef __true_type propagate_on_move_assignment;
+    typedef __true_type propagate_on_swap;
+    typedef __true_type has_reallocate;
+
+    static __default_alloc_template<inst> select_on_copy_construction(const __default_alloc_template<inst> &a) {
+        return a;
+    }
+};
+
+template <int inst>
+struct __alloc_traits<__thread_cache_alloc_template<inst> > {
+    typedef __false_type propagate_on_copy_assignment;
+    typedef __true_type propagate_on_move_assignment;
+    typedef __true_type propagate_on_swap;
+    typedef __true_type has_reallocate;
+
+    static __thread_cache_alloc_template<inst> select_on_copy_construction(const __thread_cache_alloc_template<inst> &a) {
+        return a;
+    }
+};
+
+template <int inst>
+struct __alloc_traits<__arena_alloc_template<inst> > {
+    typedef __false_type propagate_on_copy_assignment;
+    typedef __true_type propagate_on_move_assignment;
+    typedef __true_type propagate_on_swap;
+    typedef __true_type has_reallocate;
+
+    static __arena_alloc_template<inst> select_on_copy_construction(const __arena_alloc_template<inst> &a) {
+        return a;
+    }
+};
+
+template <class Alloc>
+inline void __alloc_swap(Alloc &a, Alloc &b, __true_type) {
+    Alloc tmp = a;
+    a = b;
+    b = tmp;
+}
+
+template <class Alloc>
+inline void __alloc_swap(Alloc &, Alloc &, __false_type) {
+}
+
 };
 #endif
@@ -0,0 +1,469 @@
+#ifndef __HH_STL_CIRCULAR_BUFFER_H_
+#define __HH_STL_CIRCULAR_BUFFER_H_
+
+#include<cstddef>
+#include<utility>
+#include "hh_stl_iterator.h"
+#include "hh_stl_alloc.h"
+#include "hh_stl_construct.h"
+#include "hh_config.h"
+
+namespace hh_std {
+
+// A fixed-capacity ring in one contiguous block.  The capacity is rounded up
+// to a power of two and head/tail are free-running counters, so a slot is
+// counter & mask and size() is tail - head; neither push nor pop branches on
+// wrap-around.  Storage is allocated by the constructor only.
+//
+// When the ring is full, push_back/push_front either reject the new element
+// and return false (reject_new), or overwrite the element at the other end
+// (overwrite_oldest), which suits telemetry that only wants the latest N.
+// Usable as the Sequence of queue and stack, whose push then returns the bool.
+
+template <class T, class Ref, class Ptr>
+struct __circular_buffer_iterator {
+    typedef __circular_buffer_iterator<T, T&, T*> iterator;
+    typedef __circular_buffer_iterator<T, const T&, const T*> const_iterator;
+    typedef __circular_buffer_iterator self;
+
+    typedef random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    T* buf;
+    size_type mask;
+    size_type pos;
+
+    __circular_buffer_iterator(T *b, size_type m, size_type p): buf(b), mask(m), pos(p) {}
+    __circular_buffer_iterator(): buf(0), mask(0), pos(0) {}
+    __circular_buffer_iterator(const iterator &x): buf(x.buf), mask(x.mask), pos(x.pos) {}
+
+    reference operator* () const {
+        return buf[pos & mask];
+    }
+    pointer operator-> () const {
+        return &(operator*());
+    }
+    // The counters wrap modulo 2^N, so differences are taken unsigned.
+    difference_type operator- (const self &x) const {
+        return difference_type(pos - x.pos);
+    }
+    self &operator++ () {
+        ++pos;
+        return *this;
+    }
+    self operator++ (int) {
+        self tmp = *this;
+        ++pos;
+        return tmp;
+    }
+    self &operator-- () {
+        --pos;
+        return *this;
+    }
+    self operator-- (int) {
+        self tmp = *this;
+        --pos;
+        return tmp;
+    }
+    self &operator+= (difference_type n) {
+        pos += n;
+        return *this;
+    }
+    self &operator-= (difference_type n) {
+        pos -= n;
+        return *this;
+    }
+    self operator+ (difference_type n) const {
+        self tmp = *this;
+        tmp += n;
+        return tmp;
+    }
+    self operator- (difference_type n) const {
+        self tmp = *this;
+        tmp -= n;
+        return tmp;
+    }
+    reference operator[] (difference_type n) const {
+        return *(*this + n);
+    }
+    bool operator== (const self &x) const {
+        return pos == x.pos;
+    }
+    bool operator!= (const self &x) const {
+        return pos != x.pos;
+    }
+    bool operator< (const self &x) const {
+        return *this - x < 0;
+    }
+    bool operator> (const self &x) const {
+        return x < *this;
+    }
+    bool operator<= (const self &x) const {
+        return !(x < *this);
+    }
+    bool operator>= (const self &x) const {
+        return !(*this < x);
+    }
+};
+
+template <class T, class Alloc = alloc>
+class circular_buffer: private __alloc_holder<Alloc> {
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+    typedef __circular_buffer_iterator<T, T&, T*> iterator;
+    typedef __circular_buffer_iterator<T, const T&, const T*> const_iterator;
+    typedef reverse_iterator<const_iterator> const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+
+    enum overflow_mode { reject_new, overwrite_oldest };
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef simple_alloc<value_type, Alloc> data_allocator;
+
+    pointer buf;
+    size_type cap;
+    size_type mask;
+    size_type head;
+    size_type tail;
+    overflow_mode mode;
+
+    static size_type round_capacity(size_type n) {
+        size_type c = 1;
+        while(c < n) {
+            c <<= 1;
+        }
+        return n == 0 ? 0 : c;
+    }
+    void reset(overflow_mode m) {
+        buf = 0;
+        cap = 0;
+        mask = 0;
+        head = tail = 0;
+        mode = m;
+    }
+    void allocate_storage(size_type n) {
+        cap = round_capacity(n);
+        mask = cap == 0 ? 0 : cap - 1;
+        buf = cap == 0 ? 0 : data_allocator::allocate(this->get_alloc(), cap);
+    }
+    void deallocate_storage() {
+        if(buf) {
+            data_allocator::deallocate(this->get_alloc(), buf, cap);
+        }
+        buf = 0;
+        cap = mask = 0;
+    }
+    void steal(circular_buffer &x) {
+        buf = x.buf;
+        cap = x.cap;
+        mask = x.mask;
+        head = x.head;
+        tail = x.tail;
+        mode = x.mode;
+        x.reset(x.mode);
+    }
+    // Makes the storage match x's capacity; only called on an empty ring.
+    void match_capacity(const circular_buffer &x) {
+        if(cap != x.cap) {
+            deallocate_storage();
+            allocate_storage(x.cap);
+        }
+        mode = x.mode;
+    }
+
+    void copy_assign_alloc(const circular_buffer &x, __true_type) {
+        clear();
+        deallocate_storage();
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const circular_buffer&, __false_type) {
+    }
+    void move_assign(circular_buffer &x, __true_type) {
+        clear();
+        deallocate_storage();
+        this->get_alloc() = x.get_alloc();
+        steal(x);
+    }
+    // The allocator stays put, so the elements have to be moved one by one.
+    void move_assign(circular_buffer &x, __false_type) {
+        clear();
+        match_capacity(x);
+        for(iterator it = x.begin(); it != x.end(); ++it) {
+            push_back(std::move(*it));
+        }
+        x.clear();
+    }
+public:
+    // There is no default constructor: the capacity is fixed at construction,
+    // and a ring of capacity 0 would silently drop every push.  A queue or
+    // stack over a circular_buffer adopts one built with a capacity.
+    circular_buffer() = delete;
+    // Room for n elements (at least one), rounded up to a power of two.
+    explicit circular_buffer(size_type n, overflow_mode m = reject_new, const allocator_type &a = allocator_type()):
+        alloc_base(a) {
+        reset(m);
+        allocate_storage(n == 0 ? 1 : n);
+    }
+    circular_buffer(const circular_buffer &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())) {
+        reset(x.mode);
+        allocate_storage(x.cap);
+        __STL_TRY {
+            for(const_iterator it = x.begin(); it != x.end(); ++it) {
+                push_back(*it);
+            }
+        }
+        __STL_UNWIND((clear(), deallocate_storage()));
+    }
+    circular_buffer(circular_buffer &&x): alloc_base(x.get_alloc()) {
+        steal(x);
+    }
+    circular_buffer &operator= (const circular_buffer &x) {
+        if(&x != this) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            clear();
+            match_capacity(x);
+            for(const_iterator it = x.begin(); it != x.end(); ++it) {
+                push_back(*it);
+            }
+        }
+        return *this;
+    }
+    circular_buffer &operator= (circular_buffer &&x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+    ~circular_buffer() {
+        clear();
+        deallocate_storage();
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    overflow_mode get_overflow_mode() const {
+        return mode;
+    }
+    void set_overflow_mode(overflow_mode m) {
+        mode = m;
+    }
+    iterator begin() {
+        return iterator(buf, mask, head);
+    }
+    const_iterator begin() const {
+        return const_iterator(buf, mask, head);
+    }
+    iterator end() {
+        return iterator(buf, mask, tail);
+    }
+    const_iterator end() const {
+        return const_iterator(buf, mask, tail);
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    size_type size() const {
+        return tail - head;
+    }
+    size_type max_size() const {
+        return cap;
+    }
+    size_type capacity() const {
+        return cap;
+    }
+    bool empty() const {
+        return tail == head;
+    }
+    bool full() const {
+        return tail - head == cap;
+    }
+    reference operator[] (size_type n) {
+        return buf[(head + n) & mask];
+    }
+    const_reference operator[] (size_type n) const {
+        return buf[(head + n) & mask];
+    }
+    reference at(size_type n) {
+        return (*this)[n];
+    }
+    const_reference at(size_type n) const {
+        return (*this)[n];
+    }
+    reference front() {
+        return buf[head & mask];
+    }
+    const_reference front() const {
+        return buf[head & mask];
+    }
+    reference back() {
+        return buf[(tail - 1) & mask];
+    }
+    const_reference back() const {
+        return buf[(tail - 1) & mask];
+    }
+
+    // Returns false if the ring was full and the element was not stored.
+    // When a full ring overwrites, the new element goes into the oldest
+    // element's slot by assignment, so x may refer to that element.
+    bool push_back(const T &x) {
+        if(full()) {
+            if(mode == reject_new || cap == 0) {
+                return false;
+            }
+            buf[tail & mask] = x;
+            ++head;
+            ++tail;
+            return true;
+        }
+        construct(buf + (tail & mask), x);
+        ++tail;
+        return true;
+    }
+    bool push_back(T &&x) {
+        if(full()) {
+            if(mode == reject_new || cap == 0) {
+                return false;
+            }
+            buf[tail & mask] = std::move(x);
+            ++head;
+            ++tail;
+            return true;
+        }
+        construct(buf + (tail & mask), std::move(x));
+        ++tail;
+        return true;
+    }
+    template <class... Args>
+    bool emplace_back(Args&&... args) {
+        if(full()) {
+            if(mode == reject_new || cap == 0) {
+                return false;
+            }
+            buf[tail & mask] = T(std::forward<Args>(args)...);
+            ++head;
+            ++tail;
+            return true;
+        }
+        construct(buf + (tail & mask), std::forward<Args>(args)...);
+        ++tail;
+        return true;
+    }
+    // On a full ring in overwrite_oldest mode this drops back() instead.
+    bool push_front(const T &x) {
+        if(full()) {
+            if(mode == reject_new || cap == 0) {
+                return false;
+            }
+            buf[(head - 1) & mask] = x;
+            --head;
+            --tail;
+            return true;
+        }
+        construct(buf + ((head - 1) & mask), x);
+        --head;
+        return true;
+    }
+    bool push_front(T &&x) {
+        if(full()) {
+            if(mode == reject_new || cap == 0) {
+                return false;
+            }
+            buf[(head - 1) & mask] = std::move(x);
+            --head;
+            --tail;
+            return true;
+        }
+        construct(buf + ((head - 1) & mask), std::move(x));
+        --head;
+        return true;
+    }
+    template <class... Args>
+    bool emplace_front(Args&&... args) {
+        if(full()) {
+            if(mode == reject_new || cap == 0) {
+                return false;
+            }
+            buf[(head - 1) & mask] = T(std::forward<Args>(args)...);
+            --head;
+            --tail;
+            return true;
+        }
+        construct(buf + ((head - 1) & mask), std::forward<Args>(args)...);
+        --head;
+        return true;
+    }
+    void pop_front() {
+        destory(buf + (head & mask));
+        ++head;
+    }
+    void pop_back() {
+        --tail;
+        destory(buf + (tail & mask));
+    }
+    void clear() {
+        while(!empty()) {
+            pop_front();
+        }
+        head = tail = 0;
+    }
+    void swap(circular_buffer &x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        std::swap(buf, x.buf);
+        std::swap(cap, x.cap);
+        std::swap(mask, x.mask);
+        std::swap(head, x.head);
+        std::swap(tail, x.tail);
+        std::swap(mode, x.mode);
+    }
+};
+
+template <class T, class Alloc>
+inline bool operator== (const circular_buffer<T, Alloc> &a, const circular_buffer<T, Alloc> &b) {
+    if(a.size() != b.size()) {
+        return false;
+    }
+    typename circular_buffer<T, Alloc>::const_iterator x = a.begin(), y = b.begin();
+    for(; x != a.end(); ++x, ++y) {
+        if(!(*x == *y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T, class Alloc>
+inline bool operator!= (const circular_buffer<T, Alloc> &a, const circular_buffer<T, Alloc> &b) {
+    return !(a == b);
+}
+
+template <class T, class Alloc>
+inline void swap(circular_buffer<T, Alloc> &a, circular_buffer<T, Alloc> &b) {
+    a.swap(b);
+}
+
+};
+
+#endif
@@ -0,0 +1,429 @@
+#ifndef __HH_STL_CONCURRENT_QUEUE_H_
+#define __HH_STL_CONCURRENT_QUEUE_H_
+
+#include<cstddef>
+#include<atomic>
+#include<thread>
+#include<utility>
+#include<type_traits>
+#include "hh_stl_iterator.h"
+#include "hh_stl_alloc.h"
+#include "hh_stl_construct.h"
+#include "hh_config.h"
+
+namespace hh_std {
+
+// Bounded queues for handing elements between threads without a mutex.
+//
+// mpmc_queue: any number of producers and consumers.  Every slot carries a
+//   sequence number that says whose turn it is, so a push or pop is one CAS
+//   on the shared position plus one release store on the slot.
+// spsc_queue: exactly one producer thread and one consumer thread.  Each side
+//   owns its index and keeps a cached copy of the other side's, so an
+//   operation is wait-free and usually touches only its own cache line.
+//
+// Both allocate their ring once, with the capacity rounded up to a power of
+// two.  The try_ functions never block and report full/empty by returning
+// false (or a short count for the _n batch forms); push/pop spin with
+// std::this_thread::yield() until they succeed.  The hot indices are padded
+// apart so producers and consumers do not false-share.
+
+inline size_t __concurrent_queue_capacity(size_t n, size_t min_n) {
+    size_t c = min_n;
+    while(c < n) {
+        c <<= 1;
+    }
+    return c;
+}
+
+template <class T, class Alloc = alloc>
+class mpmc_queue: private __alloc_holder<Alloc> {
+    // A slot is claimed before the element is built in it, and a claimed slot
+    // can't be handed back, so building and moving elements must not throw.
+    // push(const T&) and friends copy into a temporary first when the copy may throw.
+    static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value,
+                  "mpmc_queue needs a T with non-throwing move operations");
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+
+    // seq == pos: free for the producer of position pos.
+    // seq == pos + 1: holds the element of position pos.
+    struct slot {
+        std::atomic<size_type> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T *value() {
+            return reinterpret_cast<T*>(&storage);
+        }
+    };
+    typedef simple_alloc<slot, Alloc> slot_allocator;
+
+    slot *slots;
+    size_type mask;
+    char pad0[__STL_CACHE_LINE_SIZE - sizeof(size_type)];
+    std::atomic<size_type> enqueue_pos;
+    char pad1[__STL_CACHE_LINE_SIZE - sizeof(std::atomic<size_type>)];
+    std::atomic<size_type> dequeue_pos;
+    char pad2[__STL_CACHE_LINE_SIZE - sizeof(std::atomic<size_type>)];
+
+    static difference_type distance(size_type a, size_type b) {
+        return difference_type(a - b);
+    }
+    bool claim_push(size_type &pos) {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+        while(true) {
+            difference_type dif = distance(slots[pos & mask].seq.load(std::memory_order_acquire), pos);
+            if(dif == 0) {
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return true;
+                }
+            } else if(dif < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    bool claim_pop(size_type &pos) {
+        pos = dequeue_pos.load(std::memory_order_relaxed);
+        while(true) {
+            difference_type dif = distance(slots[pos & mask].seq.load(std::memory_order_acquire), pos + 1);
+            if(dif == 0) {
+                if(dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return true;
+                }
+            } else if(dif < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    // Claims up to n consecutive slots whose seq is pos + i + offset, where
+    // offset is 0 for producers and 1 for consumers.  A slot that is ready for
+    // pos + i stays ready until someone claims pos + i, and that would have
+    // moved the shared position past pos and failed the CAS.
+    size_type claim_n(std::atomic<size_type> &shared, size_type offset, size_type n, size_type &pos) {
+        pos = shared.load(std::memory_order_relaxed);
+        while(n != 0) {
+            size_type k = 0;
+            while(k < n && distance(slots[(pos + k) & mask].seq.load(std::memory_order_acquire), pos + k + offset) == 0) {
+                ++k;
+            }
+            if(k == 0) {
+                if(distance(slots[pos & mask].seq.load(std::memory_order_acquire), pos + offset) < 0) {
+                    return 0;
+                }
+                pos = shared.load(std::memory_order_relaxed);
+            } else if(shared.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                return k;
+            }
+        }
+        return 0;
+    }
+
+    // Ends the elements of the claimed positions [first, last) and hands
+    // their slots to the producers.
+    void release_popped(size_type first, size_type last) {
+        for(; first != last; ++first) {
+            slot &s = slots[first & mask];
+            destory(s.value());
+            s.seq.store(first + mask + 1, std::memory_order_release);
+        }
+    }
+
+    template <class... Args>
+    bool emplace_claimed(std::true_type, Args&&... args) {
+        size_type pos;
+        if(!claim_push(pos)) {
+            return false;
+        }
+        slot &s = slots[pos & mask];
+        construct(s.value(), std::forward<Args>(args)...);
+        s.seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    template <class... Args>
+    bool emplace_claimed(std::false_type, Args&&... args) {
+        T tmp(std::forward<Args>(args)...);
+        return emplace_claimed(std::true_type(), std::move(tmp));
+    }
+    template <class InputIterator>
+    size_type push_n(InputIterator first, size_type n, std::true_type) {
+        size_type pos;
+        size_type k = claim_n(enqueue_pos, 0, n, pos);
+        for(size_type i = 0; i < k; ++i, ++first) {
+            slot &s = slots[(pos + i) & mask];
+            construct(s.value(), *first);
+            s.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        return k;
+    }
+    template <class InputIterator>
+    size_type push_n(InputIterator first, size_type n, std::false_type) {
+        size_type k = 0;
+        for(; k < n && try_push(*first); ++k, ++first) {
+        }
+        return k;
+    }
+public:
+    explicit mpmc_queue(size_type n, const allocator_type &a = allocator_type()): alloc_base(a) {
+        size_type cap = __concurrent_queue_capacity(n, 2);
+        slots = slot_allocator::allocate(this->get_alloc(), cap);
+        mask = cap - 1;
+        for(size_type i = 0; i < cap; ++i) {
+            construct(&slots[i].seq, i);
+        }
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue &operator= (const mpmc_queue&) = delete;
+    // Not thread safe: no other thread may be using the queue.
+    ~mpmc_queue() {
+        size_type last = enqueue_pos.load(std::memory_order_relaxed);
+        for(size_type pos = dequeue_pos.load(std::memory_order_relaxed); pos != last; ++pos) {
+            destory(slots[pos & mask].value());
+        }
+        slot_allocator::deallocate(this->get_alloc(), slots, mask + 1);
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    size_type capacity() const {
+        return mask + 1;
+    }
+    // A snapshot that may be stale by the time it returns.
+    size_type size_approx() const {
+        size_type tail = enqueue_pos.load(std::memory_order_acquire);
+        size_type head = dequeue_pos.load(std::memory_order_acquire);
+        return distance(tail, head) > 0 ? tail - head : 0;
+    }
+
+    bool try_push(const T &x) {
+        return emplace_claimed(std::is_nothrow_copy_constructible<T>(), x);
+    }
+    bool try_push(T &&x) {
+        return emplace_claimed(std::true_type(), std::move(x));
+    }
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        return emplace_claimed(std::is_nothrow_constructible<T, Args&&...>(), std::forward<Args>(args)...);
+    }
+    bool try_pop(T &out) {
+        size_type pos;
+        if(!claim_pop(pos)) {
+            return false;
+        }
+        slot &s = slots[pos & mask];
+        out = std::move(*s.value());
+        destory(s.value());
+        s.seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+    // Pushes a prefix of [first, first + n) with one CAS and returns its length.
+    template <class InputIterator>
+    size_type try_push_n(InputIterator first, size_type n) {
+        typedef typename iterator_traits<InputIterator>::reference reference;
+        return push_n(first, n, std::is_nothrow_constructible<T, reference>());
+    }
+    // Pops up to n elements with one CAS into out, out + 1, ... and returns
+    // how many were popped.  The claimed slots can't be handed back, so if
+    // writing through out throws, the element being written and the rest of
+    // the batch are destroyed and their slots released before rethrowing.
+    template <class OutputIterator>
+    size_type try_pop_n(OutputIterator out, size_type n) {
+        size_type pos;
+        size_type k = claim_n(dequeue_pos, 1, n, pos);
+        size_type i = 0;
+        __STL_TRY {
+            for(; i < k; ++i, ++out) {
+                slot &s = slots[(pos + i) & mask];
+                *out = std::move(*s.value());
+                destory(s.value());
+                s.seq.store(pos + i + mask + 1, std::memory_order_release);
+            }
+        }
+        __STL_UNWIND(release_popped(pos + i, pos + k));
+        return k;
+    }
+    void push(const T &x) {
+        while(!try_push(x)) {
+            std::this_thread::yield();
+        }
+    }
+    void push(T &&x) {
+        while(!try_push(std::move(x))) {
+            std::this_thread::yield();
+        }
+    }
+    void pop(T &out) {
+        while(!try_pop(out)) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+template <class T, class Alloc = alloc>
+class spsc_queue: private __alloc_holder<Alloc> {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef simple_alloc<T, Alloc> data_allocator;
+
+    T *buf;
+    size_type mask;
+    char pad0[__STL_CACHE_LINE_SIZE - sizeof(size_type)];
+    // Producer side: tail is published, head_cache is the last head it saw.
+    std::atomic<size_type> tail;
+    size_type head_cache;
+    char pad1[__STL_CACHE_LINE_SIZE - sizeof(std::atomic<size_type>) - sizeof(size_type)];
+    // Consumer side.
+    std::atomic<size_type> head;
+    size_type tail_cache;
+    char pad2[__STL_CACHE_LINE_SIZE - sizeof(std::atomic<size_type>) - sizeof(size_type)];
+
+    // Free slots as seen by the producer; rereads head only when the cached
+    // value says there are fewer than n.
+    size_type free_slots(size_type t, size_type n) {
+        size_type room = mask + 1 - (t - head_cache);
+        if(room < n) {
+            head_cache = head.load(std::memory_order_acquire);
+            room = mask + 1 - (t - head_cache);
+        }
+        return room;
+    }
+    size_type ready_slots(size_type h, size_type n) {
+        size_type ready = tail_cache - h;
+        if(ready < n) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            ready = tail_cache - h;
+        }
+        return ready;
+    }
+public:
+    explicit spsc_queue(size_type n, const allocator_type &a = allocator_type()): alloc_base(a) {
+        size_type cap = __concurrent_queue_capacity(n, 1);
+        buf = data_allocator::allocate(this->get_alloc(), cap);
+        mask = cap - 1;
+        tail.store(0, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        head_cache = tail_cache = 0;
+    }
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue &operator= (const spsc_queue&) = delete;
+    ~spsc_queue() {
+        size_type last = tail.load(std::memory_order_relaxed);
+        for(size_type pos = head.load(std::memory_order_relaxed); pos != last; ++pos) {
+            destory(buf + (pos & mask));
+        }
+        data_allocator::deallocate(this->get_alloc(), buf, mask + 1);
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    size_type capacity() const {
+        return mask + 1;
+    }
+    // A snapshot that may be stale by the time it returns.  The two loads are
+    // not atomic together, so head may already be past the tail that was read.
+    size_type size_approx() const {
+        size_type t = tail.load(std::memory_order_acquire);
+        size_type h = head.load(std::memory_order_acquire);
+        return difference_type(t - h) > 0 ? t - h : 0;
+    }
+
+    // Producer thread only.
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        size_type t = tail.load(std::memory_order_relaxed);
+        if(free_slots(t, 1) == 0) {
+            return false;
+        }
+        construct(buf + (t & mask), std::forward<Args>(args)...);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool try_push(const T &x) {
+        return try_emplace(x);
+    }
+    bool try_push(T &&x) {
+        return try_emplace(std::move(x));
+    }
+    // Producer thread only.  Publishes the whole prefix with one store.
+    template <class InputIterator>
+    size_type try_push_n(InputIterator first, size_type n) {
+        size_type t = tail.load(std::memory_order_relaxed);
+        size_type room = free_slots(t, n);
+        size_type k = room < n ? room : n;
+        size_type i = 0;
+        __STL_TRY {
+            for(; i < k; ++i, ++first) {
+                construct(buf + ((t + i) & mask), *first);
+            }
+        }
+        __STL_UNWIND(tail.store(t + i, std::memory_order_release));
+        tail.store(t + k, std::memory_order_release);
+        return k;
+    }
+    // Consumer thread only.
+    bool try_pop(T &out) {
+        size_type h = head.load(std::memory_order_relaxed);
+        if(ready_slots(h, 1) == 0) {
+            return false;
+        }
+        T *p = buf + (h & mask);
+        out = std::move(*p);
+        destory(p);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    // Consumer thread only.  Frees the popped slots with one store.
+    template <class OutputIterator>
+    size_type try_pop_n(OutputIterator out, size_type n) {
+        size_type h = head.load(std::memory_order_relaxed);
+        size_type ready = ready_slots(h, n);
+        size_type k = ready < n ? ready : n;
+        size_type i = 0;
+        __STL_TRY {
+            for(; i < k; ++i, ++out) {
+                T *p = buf + ((h + i) & mask);
+                *out = std::move(*p);
+                destory(p);
+            }
+        }
+        __STL_UNWIND(head.store(h + i, std::memory_order_release));
+        head.store(h + k, std::memory_order_release);
+        return k;
+    }
+    void push(const T &x) {
+        while(!try_push(x)) {
+            std::this_thread::yield();
+        }
+    }
+    void push(T &&x) {
+        while(!try_push(std::move(x))) {
+            std::this_thread::yield();
+        }
+    }
+    void pop(T &out) {
+        while(!try_pop(out)) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+};
+
+#endif
@@ -2,12 +2,13 @@
 #define __HH_STL_CONSTRUCT_H_
 
 #include<new>
+#include<utility>
 #include "hh_type_traits.h"
 #include "hh_stl_iterator.h"
 
-template <class Point, class T>
-inline void construct(Point *p, const T &value) {
-    new (p) T((T&)value);
+template <class T, class... Args>
+inline void construct(T *p, Args&&... args) {
+    new (p) T(std::forward<Args>(args)...);
 }
 
 template <class T>
@@ -2,6 +2,8 @@
 #define __HH_STL_DEQUE_H_
 
 #include<cstddef>
+#include<utility>
+#include<cstring>
 #include "hh_stl_iterator.h"
 #include "hh_stl_alloc.h"
 #include "hh_stl_uninitialized.h"
@@ -9,8 +11,31 @@
 
 namespace hh_std {
 
-inline size_t deque_buf_size(size_t buf_size, size_t sz) {
-    return buf_size == 0 ? (sz > 512 ? 1 : 512 / sz) : buf_size;
+// The number of elements per buffer is a compile-time power of two, so iterator
+// index arithmetic is only shifts and masks.  A nonzero BufSize is rounded up
+// to a power of two.  BufSize 0 aims at 512 bytes (8 cache lines) but at least
+// 8 elements, unless 8 elements exceed a page (4096 bytes), in which case it
+// takes as many as fit in a page; the result is rounded down to a power of
+// two so the buffer never exceeds that target.
+constexpr size_t __deque_pow2_floor(size_t n) {
+    return n < 2 ? 1 : 2 * __deque_pow2_floor(n / 2);
+}
+
+constexpr size_t __deque_pow2_ceil(size_t n) {
+    return n < 2 ? 1 : 2 * __deque_pow2_ceil((n + 1) / 2);
+}
+
+constexpr size_t __deque_log2(size_t n) {
+    return n < 2 ? 0 : 1 + __deque_log2(n / 2);
+}
+
+constexpr size_t __deque_default_elems(size_t sz) {
+    return (512 / sz < 8 ? 8 : 512 / sz) * sz > 4096 ?
+           (4096 / sz == 0 ? 1 : 4096 / sz) : (512 / sz < 8 ? 8 : 512 / sz);
+}
+
+constexpr size_t deque_buf_size(size_t buf_size, size_t sz) {
+    return buf_size == 0 ? __deque_pow2_floor(__deque_default_elems(sz)) : __deque_pow2_ceil(buf_size);
 }
 
 template <class T, class Ref, class Ptr, size_t BufSize>
@@ -19,9 +44,12 @@ struct __deque_iterator {
     typedef __deque_iterator<T, const T&, const T*, BufSize> const_iterator;
     typedef __deque_iterator self;
 
-    static size_t buffer_size() {
+    static constexpr size_t buffer_size() {
         return deque_buf_size(BufSize, sizeof(T));
     }
+    static constexpr size_t buffer_shift() {
+        return __deque_log2(buffer_size());
+    }
 
     typedef random_access_iterator_tag iterator_category;
     typedef T value_type;
@@ -38,18 +66,18 @@ struct __deque_iterator {
 
     __deque_iterator(const T* x, map_pointer y): cur(x), first(x), last(x + buffer_size()), node(y) {}
     __deque_iterator() = default;
-    __deque_iterator(const __deque_iterator &x): cur(x.cur), first(x.first), last(x.last), node(x.node) {}
+    __deque_iterator(const iterator &x): cur(x.cur), first(x.first), last(x.last), node(x.node) {}
 
     reference operator* () const {
         return *cur;
     }
 
     pointer operator-> () const {
-        return *(operator*());
+        return &(operator*());
     }
 
     difference_type operator- (const self &x) const {
-        return (node - x.node - 1) * difference_type(buffer_size()) + (x.last - x.cur) + (cur - first);
+        return (node - x.node) * difference_type(buffer_size()) + (cur - first) - (x.cur - x.first);
     }
 
     void set_node(map_pointer p) {
@@ -89,14 +117,15 @@ struct __deque_iterator {
     }
 
     self &operator+= (difference_type n) {
-        difference_type bs = difference_type(buffer_size());
         difference_type offset = n + (cur - first);
-        if(offset >= 0 && offset < bs) {
+        if(offset >= 0 && offset < difference_type(buffer_size())) {
             cur += n;
         } else {
-            difference_type node_offset = offset > 0 ? offset / bs : -(-offset - 1) / bs - 1;
+            // Floor division; for a negative offset the mask after the size_t
+            // conversion still gives the right remainder.
+            difference_type node_offset = offset > 0 ? offset >> buffer_shift() : -((-offset - 1) >> buffer_shift()) - 1;
             set_node(node + node_offset);
-            cur = first + (offset - node_offset * bs);
+            cur = first + (size_t(offset) & (buffer_size() - 1));
         }
         return *this;
     }
@@ -105,38 +134,72 @@ struct __deque_iterator {
         return operator+=(-n);
     }
 
-    self operator+ (difference_type n) {
+    self operator+ (difference_type n) const {
         self tmp = *this;
         tmp += n;
         return tmp;
     }
 
-    self operator- (difference_type n) {
+    self operator- (difference_type n) const {
         self tmp = *this;
         tmp -= n;
         return tmp;
     }
 
-    reference operator[] (size_type n) {
+    reference operator[] (size_type n) const {
         return *(*this + n);
     }
 
-    bool operator== (const self &x) {
+    bool operator== (const self &x) const {
         return cur == x.cur;
     }
 
-    bool operator!= (self &x) {
+    bool operator!= (const self &x) const {
         return cur != x.cur;
     }
 
-    bool operator< (self &x) {
+    bool operator< (const self &x) const {
         return node == x.node ? cur < x.cur : (node < x.node);
     }
 
 };
 
+// Each buffer is contiguous, so algorithms can process the deque buffer by
+// buffer through raw pointers.
+template <class T, class Ref, class Ptr, size_t BufSize>
+struct __segmented_iterator_traits<__deque_iterator<T, Ref, Ptr, BufSize> > {
+    typedef __segmented_tag category;
+    typedef __deque_iterator<T, Ref, Ptr, BufSize> iterator;
+    typedef typename iterator::map_pointer segment_iterator;
+    typedef Ptr local_iterator;
+
+    static segment_iterator segment(const iterator &it) {
+        return it.node;
+    }
+    static local_iterator local(const iterator &it) {
+        return it.cur;
+    }
+    static local_iterator begin(segment_iterator s) {
+        return *s;
+    }
+    static local_iterator end(segment_iterator s) {
+        return *s + iterator::buffer_size();
+    }
+    static iterator compose(segment_iterator s, local_iterator l) {
+        iterator it;
+        if(l == end(s)) {
+            it.set_node(s + 1);
+            it.cur = it.first;
+        } else {
+            it.set_node(s);
+            it.cur = const_cast<T*>(l);
+        }
+        return it;
+    }
+};
+
 template <class T, class Alloc = alloc, size_t BufSize = 0>
-class deque {
+class deque: private __alloc_holder<Alloc> {
 public:
     typedef T value_type;
     typedef T* pointer;
@@ -145,6 +208,7 @@ public:
     typedef const T& const_reference;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 
     typedef __deque_iterator<T, T&, T*, BufSize> iterator;
     typedef __deque_iterator<T, const T&, const T*, BufSize> const_iterator;
@@ -154,17 +218,48 @@ public:
 
 protected:
     typedef pointer* map_pointer;
+    typedef __alloc_holder<Alloc> alloc_base;
     typedef simple_alloc<T, Alloc> data_allocater;
     typedef simple_alloc<pointer, Alloc> map_allocater;
 
-    static size_type buffer_size() {
+    // Used as a queue, pop_front frees a buffer just before push_back needs
+    // one.  Freed buffers go to spare first and are handed back on the next
+    // allocation, so a steady queue stops calling the allocator.
+    pointer allocate_node() {
+        if(spare_count != 0) {
+            return spare[--spare_count];
+        }
+        return data_allocater::allocate(this->get_alloc(), buffer_size());
+    }
+    void deallocate_node(pointer p) {
+        if(spare_count < max_spare_nodes()) {
+            spare[spare_count++] = p;
+        } else {
+            data_allocater::deallocate(this->get_alloc(), p, buffer_size());
+        }
+    }
+    void release_spare_nodes() {
+        while(spare_count != 0) {
+            data_allocater::deallocate(this->get_alloc(), spare[--spare_count], buffer_size());
+        }
+    }
+
+    static constexpr size_type buffer_size() {
         return deque_buf_size(BufSize, sizeof(value_type));
     }
+    static constexpr size_type buffer_shift() {
+        return __deque_log2(buffer_size());
+    }
 
     static size_type initial_map_size() {
         return 8;
     }
 
+    enum { __spare_nodes = 2 };
+    static size_type max_spare_nodes() {
+        return __spare_nodes;
+    }
+
     iterator start;
     iterator finish;
 
@@ -172,7 +267,13 @@ protected:
 
     size_type map_size;
 
+    pointer spare[__spare_nodes];
+    size_type spare_count;
+
 public:
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
     iterator begin() {
         return start;
     }
@@ -197,11 +298,15 @@ public:
     const_r_iterator rend() const {
         return const_r_iterator(begin());
     }
+    // Goes straight through the map instead of an iterator: one shift finds
+    // the buffer and one mask finds the slot.
     reference operator[] (size_type n) {
-        return *(start + n);
+        size_type offset = n + (start.cur - start.first);
+        return start.node[offset >> buffer_shift()][offset & (buffer_size() - 1)];
     }
     const_reference operator[] (size_type n) const {
-        return *(start + n);
+        size_type offset = n + (start.cur - start.first);
+        return start.node[offset >> buffer_shift()][offset & (buffer_size() - 1)];
     }
     reference front() {
         return *start;
@@ -224,45 +329,62 @@ public:
     bool empty() const {
         return start == finish;
     }
-    deque(): start(), finish(), map(0), map_size(0) {
+    deque(): start(), finish(), map(0), map_size(0), spare_count(0) {
         create_map_and_nodes(0);
     }
-    deque(size_type n, const value_type &x): start(), finish(), map(0), map_size(0) {
+    explicit deque(const allocator_type &a): alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
+        create_map_and_nodes(0);
+    }
+    deque(size_type n, const value_type &x, const allocator_type &a = allocator_type()):
+        alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
         fill_initialize(n, x);
     }
-    deque(int n, const value_type &x): start(), finish(), map(0), map_size(0) {
+    deque(int n, const value_type &x, const allocator_type &a = allocator_type()):
+        alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
         fill_initialize(n, x);
     }
-    deque(long n, const value_type &x): start(), finish(), map(0), map_size(0) {
+    deque(long n, const value_type &x, const allocator_type &a = allocator_type()):
+        alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
         fill_initialize(n, x);
     }
-    deque(size_type n): start(), finish(), map(0), map_size(0) {
+    deque(size_type n): start(), finish(), map(0), map_size(0), spare_count(0) {
         fill_initialize(n, value_type());
     }
-    deque(const deque &x): start(), finish(), map(0), map_size(0) {
+    deque(const deque &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())),
+        start(), finish(), map(0), map_size(0), spare_count(0) {
         create_map_and_nodes(x.size());
         uninitialized_copy(x.begin(), x.end(), start);
     }
-    deque(const_pointer first, const_pointer last): start(), finish(), map(0), map_size(0) {
+    deque(deque &&x): alloc_base(x.get_alloc()), start(), finish(), map(0), map_size(0), spare_count(0) {
+        create_map_and_nodes(0);
+        swap_data(x);
+    }
+    deque(const_pointer first, const_pointer last, const allocator_type &a = allocator_type()):
+        alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
         create_map_and_nodes(last - first);
         uninitialized_copy(first, last, start);
     }
-    deque(const_iterator first, const_iterator last) : start(), finish(), map(0), map_size(0) {
+    deque(const_iterator first, const_iterator last, const allocator_type &a = allocator_type()):
+        alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
         create_map_and_nodes(last - first);
         uninitialized_copy(first, last, start);
     }
     template <class InputIterator>
-    deque(InputIterator first, InputIterator last): start(), finish(), map(0), map_size(0) {
+    deque(InputIterator first, InputIterator last, const allocator_type &a = allocator_type()):
+        alloc_base(a), start(), finish(), map(0), map_size(0), spare_count(0) {
         range_initialize(first, last, category_type(first));
     }
     ~deque() {
-        destory(start.cur, finish.cur);
+        destory(start, finish);
         destory_map_and_nodes();
+        release_spare_nodes();
     }
     deque &operator= (const deque &x) {
-        if(*this != x) {
+        if(this != &x) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
             if(size() == x.size()) {
-                std::copy(x.begin, x.end(), start);
+                std::copy(x.begin(), x.end(), start);
             } else if(size() > x.size()) {
                 std::copy(x.begin(), x.end(), start);
                 erase(finish - (size() - x.size()), finish);
@@ -273,26 +395,45 @@ public:
         }
         return *this;
     }
+    deque &operator= (deque &&x) {
+        if(this != &x) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
     void swap(deque &x) {
-        std::swap(map, x.map);
-        std::swap(map_size, x.map_size);
-        std::swap(start, x.start);
-        std::swap(finish, x.finish);
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        swap_data(x);
     }
     void push_back(const value_type &x) {
+        emplace_back(x);
+    }
+    void push_back(value_type &&x) {
+        emplace_back(std::move(x));
+    }
+    template <class... Args>
+    void emplace_back(Args&&... args) {
         if(finish.cur == finish.last - 1) {
-            push_back_aux(x);
+            push_back_aux(std::forward<Args>(args)...);
         } else {
-            construct(finish.cur, x);
+            construct(finish.cur, std::forward<Args>(args)...);
             ++finish;
         }
     }
     void push_front(const value_type &x) {
+        emplace_front(x);
+    }
+    void push_front(value_type &&x) {
+        emplace_front(std::move(x));
+    }
+    template <class... Args>
+    void emplace_front(Args&&... args) {
         if(start.cur == start.first) {
-            push_front_aux(x);
+            push_front_aux(std::forward<Args>(args)...);
         } else {
+            construct(start.cur - 1, std::forward<Args>(args)...);
             --start;
-            construct(start.cur, x);
         }
     }
     void pop_back() {
@@ -321,16 +462,16 @@ public:
         } else {
             difference_type n = pos - start;
             if(n < (size() / 2)) {
-                std::copy_backward(start, pos, pos + 1);
+                std::move_backward(start, pos, pos + 1);
                 destory(start.cur);
                 if (start.cur == start.last - 1) {
-                    data_allocater::deallocate(start.first, buffer_size());
+                    deallocate_node(start.first);
                 }
                 ++start;
             } else {
-                std::copy(pos + 1, finish, pos);
+                std::move(pos + 1, finish, pos);
                 if(finish.cur == finish.first) {
-                    data_allocater::deallocate(finish.first, buffer_size());
+                    deallocate_node(finish.first);
                 }
                 --finish;
                 destory(finish.cur);
@@ -339,102 +480,117 @@ public:
         }
     }
     iterator erase(iterator first, iterator last) {
-        if(first == start && last == finish) {
+        if(first == last) {
+            return first;
+        } else if(first == start && last == finish) {
             clear();
             return start;
         } else if(first == start) {
             map_pointer pre = first.node;
-            destory(first.cur, last.cur);
+            destory(first, last);
             start = last;
             for(; pre < start.node; pre++) {
-                data_allocater::deallocate(*pre, buffer_size());
+                deallocate_node(*pre);
             }
             return start;
         } else if(last == finish) {
             map_pointer end = last.node;
-            destory(first.cur, last.cur);
+            destory(first, last);
             finish = first;
             for(map_pointer cur = finish.node + 1; cur <= end; cur++) {
-                data_allocater::deallocate(*cur, buffer_size());
+                deallocate_node(*cur);
             }
             return finish;
         } else {
             difference_type gap = first - start;
             difference_type n = last - first;
             if(first - start < finish - last) {
-                std::copy_backward(start, first, last);
+                std::move_backward(start, first, last);
+                destory(start, start + n);
                 map_pointer pre = start.node;
                 start += n;
                 for(; pre < start.node; pre++) {
-                    data_allocater::deallocate(*pre, buffer_size());
+                    deallocate_node(*pre);
                 }
             } else {
-                std::copy(last, finish, first);
-                destory((finish - n).cur, finish.cur);
+                std::move(last, finish, first);
+                destory(finish - n, finish);
                 map_pointer pre = finish.node;
                 finish -= n;
                 for(map_pointer cur = finish.node + 1; cur <= pre; cur++) {
-                    data_allocater::deallocate(*cur, buffer_size());
+                    deallocate_node(*cur);
                 }
             }
             return start + gap;
         }
     }
     void clear() {
-        destory(start.cur, finish.cur);
-        for(map_pointer cur = start.node + 1; cur < finish.node; cur++) {
-            data_allocater::deallocate(*cur, buffer_size());
-        }
-        if(start.node != finish.node) {
-            data_allocater::deallocate(finish.first, buffer_size());
+        destory(start, finish);
+        for(map_pointer cur = start.node + 1; cur <= finish.node; cur++) {
+            deallocate_node(*cur);
         }
         finish = start;
     }
+    // Returns the cached spare buffers to the allocator.
+    void shrink_to_fit() {
+        release_spare_nodes();
+    }
     iterator insert(iterator pos, const value_type &x) {
+        return emplace(pos, x);
+    }
+    iterator insert(iterator pos, value_type &&x) {
+        return emplace(pos, std::move(x));
+    }
+    template <class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
         if (pos == start) {
-            push_front(x);
+            emplace_front(std::forward<Args>(args)...);
             return start ;
         } else if(pos == finish) {
-            push_back(x);
+            emplace_back(std::forward<Args>(args)...);
             return finish - 1;
         } else {
-            return insert_aux(pos, x);
+            return insert_aux(pos, std::forward<Args>(args)...);
         }
     }
     iterator insert(iterator pos) {
         return insert(pos, value_type());
     }
     iterator insert(iterator pos, size_type n, const value_type &x) {
-        size_type add_nodes_back = (n > (finish.last - finish.cur - 1)) ? (n - (finish.last - finish.cur - 1) - 1) / buffer_size() + 1 : 0;
-        size_type add_nodes_front = (n > (start.cur - start.first)) ? (n - (start.cur - start.first) - 1) / buffer_size() + 1 : 0;
         difference_type pres = pos - start;
+        if(n == 0) {
+            return pos;
+        }
+        value_type x_copy(x);    // x may be an element that is about to move
         if(pres < size() / 2) {
-            reserve_map_at_front(add_nodes_front);
+            reserve_elements_at_front(n);
+            pos = start + pres;
             if(n >= size_type(pres)) {
-                uninitialized_copy(start, pos, start - difference_type(n));
+                uninitialized_move(start, pos, start - difference_type(n));
                 if(n > size_type(pres)) {
-                    uninitialized_fill(pos - difference_type(n), start, x);
+                    uninitialized_fill(pos - difference_type(n), start, x_copy);
                 }
-                std::fill(start, pos, x);
+                std::fill(start, pos, x_copy);
             } else {
-                uninitialized_copy(start, start + difference_type(n), start - difference_type(n));
-                std::copy(start + difference_type(n), pos, start);
-                std::fill(pos - difference_type(n), pos, x);
+                uninitialized_move(start, start + difference_type(n), start - difference_type(n));
+                std::move(start + difference_type(n), pos, start);
+                std::fill(pos - difference_type(n), pos, x_copy);
             }
             start -= difference_type(n);
         } else {
-            reserve_map_at_back(add_nodes_back);
+            reserve_elements_at_back(n);
+            pos = start + pres;
             difference_type after = finish - pos;
             if (n >= size_type(after)) {
-                uninitialized_copy(pos, finish, pos + difference_type(n));
+                uninitialized_move(pos, finish, pos + difference_type(n));
                 if(n > size_type(after)) {
-                    uninitialized_fill(finish, pos + difference_type(n), x);
+                    uninitialized_fill(finish, pos + difference_type(n), x_copy);
                 }
-                std::fill(pos, finish, x);
+                std::fill(pos, finish, x_copy);
             } else {
-                uninitialized_copy(finish - difference_type(n), finish, finish);
-                std::copy_backward(pos, finish - difference_type(n), finish);
-                std::fill(pos, pos + difference_type(n), x);
+                uninitialized_move(finish - difference_type(n), finish, finish);
+                std::move_backward(pos, finish - difference_type(n), finish);
+                std::fill(pos, pos + difference_type(n), x_copy);
             }
             finish += difference_type(n);
         }
@@ -467,13 +623,15 @@ public:
         return size() != x.size() || !std::equal(begin(), end(), x.begin());
     }
     bool operator< (const deque &x) {
-        iterator first = begin(), first_x = x.begin();
+        const_iterator first = begin(), first_x = x.begin();
         while(first != end() && first_x != x.end()) {
             if(*first < *first_x) {
                 return true;
-            } else if(*first > *first_x) {
+            } else if(*first_x < *first) {
                 return false;
             }
+            ++first;
+            ++first_x;
         }
         return first_x != x.end();
     }
@@ -490,36 +648,39 @@ protected:
     }
     template <class ForwardIterator>
     void insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
-        size_type dis = distance(first, last);
-        size_type add_nodes_back = (dis > (finish.last - finish.cur - 1)) ? (dis - (finish.last - finish.cur - 1) - 1) / buffer_size() + 1 : 0;
-        size_type add_nodes_front = (dis > (start.cur - start.first)) ? (dis - (start.cur - start.first) - 1) / buffer_size() + 1 : 0;
+        size_type dis = hh_std::distance(first, last);
+        if(dis == 0) {
+            return;
+        }
         difference_type pres = pos - start;
         if(pres < size() / 2) {
-            reserve_map_at_front(add_nodes_front);
+            reserve_elements_at_front(dis);
+            pos = start + pres;
             if(dis >= size_type(pres)) {
-                uninitialized_copy(start, pos, start - difference_type(dis));
+                uninitialized_move(start, pos, start - difference_type(dis));
                 if(dis > size_type(pres)) {
                     uninitialized_copy(first, first + (dis - pres), pos - difference_type(dis));
                 }
                 std::copy(first + (dis - pres), last, start);
             } else {
-                uninitialized_copy(start, start + difference_type(dis), start - difference_type(dis));
-                std::copy(start + difference_type(dis), pos, start);
+                uninitialized_move(start, start + difference_type(dis), start - difference_type(dis));
+                std::move(start + difference_type(dis), pos, start);
                 std::copy(first, last, pos - difference_type(dis));
             }
             start -= difference_type(dis);
         } else {
-            reserve_map_at_back(add_nodes_back);
+            reserve_elements_at_back(dis);
+            pos = start + pres;
             difference_type after = finish - pos;
             if (dis >= size_type(after)) {
-                uninitialized_copy(pos, finish, pos + difference_type(dis));
+                uninitialized_move(pos, finish, pos + difference_type(dis));
                 if(dis > size_type(after)) {
                     uninitialized_copy(last - (dis - after), last, finish);
                 }
                 std::copy(first, last - (dis - after), pos);
             } else {
-                uninitialized_copy(finish - difference_type(dis), finish, finish);
-                std::copy_backward(pos, finish - difference_type(dis), finish);
+                uninitialized_move(finish - difference_type(dis), finish, finish);
+                std::move_backward(pos, finish - difference_type(dis), finish);
                 std::copy(first, last, pos);
             }
             finish += difference_type(dis);
@@ -527,14 +688,14 @@ protected:
     }
     template <class InputIterator>
     void range_initialize(InputIterator first, InputIterator last, input_iterator_tag) {
+        create_map_and_nodes(0);
         for(; first != last; first++) {
             push_back(*first);
-            +first;
         }
     }
     template <class ForwardIterator>
     void range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
-        size_type n = distance(first, last);
+        size_type n = hh_std::distance(first, last);
         create_map_and_nodes(n);
         uninitialized_copy(first, last, start);
     }
@@ -542,143 +703,209 @@ protected:
         create_map_and_nodes(n);
         uninitialized_fill(start, finish, x);
     }
-    iterator insert_aux(iterator pos, const value_type &x) {
+    template <class... Args>
+    iterator insert_aux(iterator pos, Args&&... args) {
+        value_type x_copy(std::forward<Args>(args)...);
         difference_type n = pos - start;
-        if(n < size() / 2) {
-            push_front(front());
-            std::copy(start + 2, pos, start + 1);
-            --pos;
+        if(size_type(n) < size() / 2) {
+            push_front(std::move(front()));
+            std::move(start + 2, start + (n + 1), start + 1);
         } else {
-            push_back(back());
-            std::copy_backward(pos, finish - 2, finish - 1);
+            push_back(std::move(back()));
+            std::move_backward(start + n, finish - 2, finish - 1);
         }
-        *pos = x;
+        pos = start + n;
+        *pos = std::move(x_copy);
         return pos;
     }
-    void push_front_aux(const value_type &x) {
+    template <class... Args>
+    void push_front_aux(Args&&... args) {
         reserve_map_at_front();
-        *(start.node - 1) = data_allocater::allocate(buffer_size());
-        --start;
-        construct(start.cur, x);
+        *(start.node - 1) = allocate_node();
+        try {
+            --start;
+            construct(start.cur, std::forward<Args>(args)...);
+        } catch(...) {
+            ++start;
+            deallocate_node(*(start.node - 1));
+            throw;
+        }
     }
-    void push_back_aux(const value_type &x) {
+    template <class... Args>
+    void push_back_aux(Args&&... args) {
         reserve_map_at_back();
-        construct(finish.cur, x);
-        *(finish.node + 1) = data_allocater::allocate(buffer_size());
+        *(finish.node + 1) = allocate_node();
+        try {
+            construct(finish.cur, std::forward<Args>(args)...);
+        } catch(...) {
+            deallocate_node(*(finish.node + 1));
+            throw;
+        }
         ++finish;
     }
-    void reserve_map_at_front(size_type n = 1) {
-        if(start.node - map < n) {
-            if(map_size - (finish.node - start.node + 1 ) >= n) {
-                difference_type gap = n - (start.node - map);
-                std::copy_backward(start.node, finish.node + 1, finish.node + gap + 1);
-                start.set_node(start.node + gap);
-                finish.set_node(finish.node + gap);
-                for(map_pointer cur = map; cur < start.node; cur++) {
-                    *cur = data_allocater::allocate(buffer_size());
+    // Make room for n elements in front of start, allocating buffers as
+    // needed; start itself is not moved.
+    void reserve_elements_at_front(size_type n) {
+        size_type vacancies = start.cur - start.first;
+        if(n > vacancies) {
+            size_type new_nodes = (n - vacancies + buffer_size() - 1) >> buffer_shift();
+            reserve_map_at_front(new_nodes);
+            size_type i = 1;
+            try {
+                for(; i <= new_nodes; i++) {
+                    *(start.node - i) = allocate_node();
                 }
-            } else {
-                reallocate_map(n, true);
-            }
-        } else {
-            map_pointer cur = start.node - 1;
-            while(n > 0) {
-                *cur = data_allocater::allocate(buffer_size());
-                --n;
-                --cur;
+            } catch(...) {
+                for(size_type j = 1; j < i; j++) {
+                    deallocate_node(*(start.node - j));
+                }
+                throw;
             }
         }
     }
-    void reserve_map_at_back(size_type n = 1) {
-        if(buffer_size() - (finish.node - map) - 1 < n) {
-            if(map_size - (finish.node - start.node + 1 ) >= n) {
-                difference_type gap = n - (buffer_size() - (finish.node - map) - 1);
-                std::copy(start.node, finish.node + 1, start.node - gap);
-                start.set_node(start.node - gap);
-                finish.set_node(finish.node - gap);
-                for(map_pointer cur = finish.node + 1; cur < map + map_size; cur++) {
-                    *cur = data_allocater::allocate(buffer_size());
+    void reserve_elements_at_back(size_type n) {
+        size_type vacancies = (finish.last - finish.cur) - 1;
+        if(n > vacancies) {
+            size_type new_nodes = (n - vacancies + buffer_size() - 1) >> buffer_shift();
+            reserve_map_at_back(new_nodes);
+            size_type i = 1;
+            try {
+                for(; i <= new_nodes; i++) {
+                    *(finish.node + i) = allocate_node();
                 }
-            } else {
-                reallocate_map(n, false);
-            }
-        } else {
-            map_pointer cur = finish.node + 1;
-            while(n > 0) {
-                *cur = data_allocater::allocate(buffer_size());
-                ++cur;
-                --n;
+            } catch(...) {
+                for(size_type j = 1; j < i; j++) {
+                    deallocate_node(*(finish.node + j));
+                }
+                throw;
             }
         }
     }
+    // The reserve_map_* functions only make map slots available; the caller
+    // allocates the buffers that go into them.
+    void reserve_map_at_front(size_type n = 1) {
+        if(size_type(start.node - map) < n) {
+            reallocate_map(n, true);
+        }
+    }
+    void reserve_map_at_back(size_type n = 1) {
+        if(map_size - (finish.node - map) - 1 < n) {
+            reallocate_map(n, false);
+        }
+    }
+    // If at least half of the map is free, the used range is moved back to the
+    // middle of the map in place, so queue-style push_back/pop_front only
+    // memmoves a few pointers now and then instead of reallocating the map.
     void reallocate_map(size_type n, bool add_front) {
         size_type old_size = finish.node - start.node + 1;
-        size_type new_map_size = map_size + std::max(map_size, old_size + n + 2);
-        map_pointer new_map, new_start, new_finish;
-        try {
-            new_map = map_allocater::allocate(new_map_size);
-        } catch(...) {
-            map_allocater::deallocate(new_map, new_map_size);
-            throw;
+        size_type new_num_nodes = old_size + n;
+        map_pointer new_start;
+        if(map_size > 2 * new_num_nodes) {
+            new_start = map + (map_size - new_num_nodes) / 2 + (add_front ? n : 0);
+            memmove(new_start, start.node, old_size * sizeof(pointer));
+        } else {
+            size_type new_map_size = map_size + std::max(map_size, new_num_nodes + 2);
+            size_type offset = (new_map_size - new_num_nodes) / 2 + (add_front ? n : 0);
+            new_start = relocate_map(new_map_size, offset, old_size,
+                                     typename __alloc_traits<Alloc>::has_reallocate());
         }
-        new_start = new_map + (new_map_size - old_size) / 2 + (add_front ? n : 0);
-        std::copy(start.node, finish.node + 1, new_start);
-        map_allocater::deallocate(map, map_size);
-        map = new_map;
-        map_size = new_map_size;
         start.set_node(new_start);
         finish.set_node(new_start + old_size - 1);
-        map_pointer cur = (add_front ? start.node - 1 : finish.node + 1);
-        while(n > 0) {
-            *cur = data_allocater::allocate(buffer_size());
-            --n;
-            add_front ? --cur : ++cur;
-        }
+    }
+    // Map slots are plain pointers, so the live window travels with memmove
+    // and an allocator with reallocate can often extend the map in place.
+    map_pointer relocate_map(size_type new_map_size, size_type offset, size_type old_size, __true_type) {
+        size_type old_offset = start.node - map;
+        map = map_allocater::reallocate(this->get_alloc(), map, map_size, new_map_size);
+        memmove(map + offset, map + old_offset, old_size * sizeof(pointer));
+        map_size = new_map_size;
+        return map + offset;
+    }
+    map_pointer relocate_map(size_type new_map_size, size_type offset, size_type old_size, __false_type) {
+        map_pointer new_map = map_allocater::allocate(this->get_alloc(), new_map_size);
+        memcpy(new_map + offset, start.node, old_size * sizeof(pointer));
+        map_allocater::deallocate(this->get_alloc(), map, map_size);
+        map = new_map;
+        map_size = new_map_size;
+        return map + offset;
     }
     void pop_front_aux() {
         destory(start.cur);
-        data_allocater::deallocate(start.first);
+        deallocate_node(start.first);
         start.set_node(start.node + 1);
         start.cur = start.first;
     }
     void pop_back_aux() {
-        data_allocater::deallocate(finish.first);
+        deallocate_node(finish.first);
         finish.set_node(finish.node - 1);
         finish.cur = finish.last - 1;
         destory(finish.cur);
     }
     void create_map_and_nodes(size_type n) {
-        size_type node_size = n / buffer_size() + 1;
+        size_type node_size = (n >> buffer_shift()) + 1;
         size_type new_map_size = std::max(initial_map_size(), node_size + 2);
-        map_pointer new_map;
-        iterator new_start, new_finish;
+        map_pointer new_map = map_allocater::allocate(this->get_alloc(), new_map_size);
+        map_pointer new_start = new_map + (new_map_size - node_size) / 2;
+        map_pointer new_finish = new_start + node_size - 1;
+        map_pointer cur = new_start;
         try {
-            new_map = map_allocater::allocate(new_map_size);
-            map_pointer cur = new_map + (new_map_size - node_size) / 2;
-            for(map_pointer tmp = cur; tmp < (cur + node_size); tmp++) {
-                *tmp = data_allocater::allocate(buffer_size());
+            for(; cur <= new_finish; cur++) {
+                *cur = allocate_node();
             }
-            new_start.set_node(cur);
-            new_finish.set_node(cur + node_size - 1);
         } catch(...) {
-            for(map_pointer tmp = new_start.node; tmp <= new_finish.node; tmp++) {
-                data_allocater::deallocate(*tmp, buffer_size());
+            for(map_pointer tmp = new_start; tmp < cur; tmp++) {
+                deallocate_node(*tmp);
             }
-            map_allocater::deallocate(new_map, new_map_size);
+            map_allocater::deallocate(this->get_alloc(), new_map, new_map_size);
             throw;
         }
         map = new_map;
         map_size = new_map_size;
-        start = new_start;
+        start.set_node(new_start);
         start.cur = start.first;
-        finish = new_finish;
-        finish.cur = finish.first + n % buffer_size();
+        finish.set_node(new_finish);
+        finish.cur = finish.first + (n & (buffer_size() - 1));
     }
     void destory_map_and_nodes() {
         for(map_pointer cur = start.node; cur <= finish.node; cur++) {
-            data_allocater::deallocate(*cur, buffer_size());
+            deallocate_node(*cur);
+        }
+        map_allocater::deallocate(this->get_alloc(), map, map_size);
+    }
+    void copy_assign_alloc(const deque &x, __true_type) {
+        destory(start, finish);
+        destory_map_and_nodes();
+        release_spare_nodes();
+        this->get_alloc() = x.get_alloc();
+        create_map_and_nodes(0);
+    }
+    void copy_assign_alloc(const deque &, __false_type) {
+    }
+    void swap_data(deque &x) {
+        std::swap(map, x.map);
+        std::swap(map_size, x.map_size);
+        std::swap(start, x.start);
+        std::swap(finish, x.finish);
+        // The spare buffers belong with the allocator, so they swap with the map.
+        pointer tmp[__spare_nodes];
+        std::copy(spare, spare + spare_count, tmp);
+        std::copy(x.spare, x.spare + x.spare_count, spare);
+        std::copy(tmp, tmp + spare_count, x.spare);
+        std::swap(spare_count, x.spare_count);
+    }
+    // x ends up owning our old (emptied) map, so it has to take our
+    // allocator along with it.
+    void move_assign(deque &x, __true_type) {
+        clear();
+        swap_data(x);
+        __alloc_swap(this->get_alloc(), x.get_alloc(), __true_type());
+    }
+    void move_assign(deque &x, __false_type) {
+        clear();
+        for(iterator cur = x.begin(); cur != x.end(); ++cur) {
+            push_back(std::move(*cur));
         }
-        map_allocater::deallocate(map, map_size);
+        x.clear();
     }
 
 };
@@ -0,0 +1,207 @@
+#ifndef __HH_STL_FLAT_MULTIMAP_H_
+#define __HH_STL_FLAT_MULTIMAP_H_
+
+#include "hh_stl_alloc.h"
+#include "hh_stl_flat_tree.h"
+#include "hh_stl_pair.h"
+
+namespace hh_std {
+
+
+template <class Key, class T, class Compare, class Alloc>
+class flat_multimap;
+
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator== (const flat_multimap<Key, T, Compare, Alloc> &x, const flat_multimap<Key, T, Compare, Alloc> &y) {
+    return x.t == y.t;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator< (const flat_multimap<Key, T, Compare, Alloc> &x, const flat_multimap<Key, T, Compare, Alloc> &y) {
+    return x.t < y.t;
+}
+
+// Same interface as multimap, with the elements stored contiguously in a sorted vector.
+// Elements move around inside the vector, so value_type's key is not const;
+// do not modify a key through an iterator.  Insert and erase invalidate iterators.
+template <class Key, class T, class Compare = std::less<Key>, class Alloc = alloc>
+class flat_multimap {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef hh_std::pair<key_type, data_type> value_type;
+    typedef Compare key_compare;
+    class value_compare: public std::binary_function<value_type, value_type, bool> {
+    private:
+        Compare comp;
+    public:
+        value_compare(const Compare &c): comp(c) {}
+        bool operator() (const value_type &x, const value_type &y) const {
+            return comp(x.first, y.first);
+        }
+    };
+private:
+    typedef hh_std::flat_tree<value_type, key_type, hh_std::select1st<value_type>, Compare, Alloc> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::r_iterator r_iterator;
+    typedef typename rep_type::const_r_iterator const_r_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::allocator_type allocator_type;
+
+    flat_multimap(): t(Compare()) {}
+    explicit flat_multimap(const Compare &c): t(c) {}
+    template <class InputIterator>
+    flat_multimap(InputIterator first, InputIterator last): t(Compare()) {
+        t.insert_equal(first, last);
+    }
+    template <class InputIterator>
+    flat_multimap(InputIterator first, InputIterator last, const Compare &c): t(c) {
+        t.insert_equal(first, last);
+    }
+    flat_multimap(const Compare &c, const allocator_type &a): t(c, a) {}
+    flat_multimap(const flat_multimap<Key, T, Compare, Alloc> &x): t(x.t) {}
+    flat_multimap<Key, T, Compare, Alloc> &operator= (const flat_multimap<Key, T, Compare, Alloc> &x) {
+        t = x.t;
+        return *this;
+    }
+    flat_multimap(flat_multimap<Key, T, Compare, Alloc> &&x): t(std::move(x.t)) {}
+    flat_multimap<Key, T, Compare, Alloc> &operator= (flat_multimap<Key, T, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
+    allocator_type get_allocator() const {
+        return t.get_allocator();
+    }
+    key_compare key_comp() const {
+        return t.key_comp();
+    }
+    value_compare value_comp() const {
+        return value_compare(t.key_comp());
+    }
+    iterator begin() {
+        return t.begin();
+    }
+    const_iterator begin() const {
+        return t.begin();
+    }
+    iterator end() {
+        return t.end();
+    }
+    const_iterator end() const {
+        return t.end();
+    }
+    r_iterator rbegin() {
+        return t.rbegin();
+    }
+    const_r_iterator rbegin() const {
+        return t.rbegin();
+    }
+    r_iterator rend() {
+        return t.rend();
+    }
+    const_r_iterator rend() const {
+        return t.rend();
+    }
+    size_type size() const {
+        return t.size();
+    }
+    bool empty() const {
+        return t.empty();
+    }
+    size_type max_size() const {
+        return t.max_size();
+    }
+    size_type capacity() const {
+        return t.capacity();
+    }
+    void reserve(size_type n) {
+        t.reserve(n);
+    }
+    void swap(flat_multimap<Key, T, Compare, Alloc> &x) {
+        t.swap(x.t);
+    }
+    iterator insert(const value_type &x) {
+        return t.insert_equal(x);
+    }
+    iterator insert(const_iterator pos, const value_type &x) {
+        return t.insert_equal(pos, x);
+    }
+    iterator insert(value_type &&x) {
+        return t.insert_equal(std::move(x));
+    }
+    iterator insert(const_iterator pos, value_type &&x) {
+        return t.insert_equal(pos, std::move(x));
+    }
+    template <class... Args>
+    iterator emplace(Args&&... args) {
+        return t.emplace_equal(std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    iterator emplace_hint(const_iterator pos, Args&&... args) {
+        return t.emplace_hint_equal(pos, std::forward<Args>(args)...);
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_equal(first, last);
+    }
+    iterator erase(const_iterator pos) {
+        return t.erase(pos);
+    }
+    size_type erase(const key_type &k) {
+        return t.erase(k);
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        return t.erase(first, last);
+    }
+    void clear() {
+        t.clear();
+    }
+    iterator find(const key_type &k) {
+        return t.find(k);
+    }
+    const_iterator find(const key_type &k) const {
+        return t.find(k);
+    }
+    size_type count(const key_type &k) const {
+        return t.count(k);
+    }
+    iterator lower_bound(const key_type &k) {
+        return t.lower_bound(k);
+    }
+    const_iterator lower_bound(const key_type &k) const {
+        return t.lower_bound(k);
+    }
+    iterator upper_bound(const key_type &k) {
+        return t.upper_bound(k);
+    }
+    const_iterator upper_bound(const key_type &k) const {
+        return t.upper_bound(k);
+    }
+    hh_std::pair<iterator, iterator> equal_range(const key_type &k) {
+        return t.equal_range(k);
+    }
+    hh_std::pair<const_iterator, const_iterator> equal_range(const key_type &k) const {
+        return t.equal_range(k);
+    }
+    friend bool operator== <> (const flat_multimap &x, const flat_multimap &y);
+    friend bool operator< <> (const flat_multimap &x, const flat_multimap &y);
+};
+
+template <class Key, class T, class Compare, class Alloc>
+inline void swap(flat_multimap<Key, T, Compare, Alloc> &x, flat_multimap<Key, T, Compare, Alloc> &y) {
+    x.swap(y);
+}
+
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef __HH_STL_FLAT_SET_H_
+#define __HH_STL_FLAT_SET_H_
+
+#include "hh_stl_alloc.h"
+#include "hh_stl_flat_tree.h"
+#include "hh_stl_functional.h"
+
+namespace hh_std {
+
+template <class Key, class Compare, class Alloc>
+class flat_set;
+
+template <class Key, class Compare, class Alloc>
+bool operator== (const flat_set<Key, Compare, Alloc> &x, const flat_set<Key, Compare, Alloc> &y) {
+    return x.t == y.t;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator< (const flat_set<Key, Compare, Alloc> &x, const flat_set<Key, Compare, Alloc> &y) {
+    return x.t < y.t;
+}
+
+// Same interface as set, with the elements stored contiguously in a sorted vector.
+// Insert and erase invalidate iterators.
+template <class Key, class Compare = std::less<Key>, class Alloc = alloc>
+class flat_set {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+private:
+    typedef hh_std::flat_tree<value_type, key_type, hh_std::identity<value_type>, Compare, Alloc> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::const_r_iterator r_iterator;
+    typedef typename rep_type::const_r_iterator const_r_iterator;
+    typedef typename rep_type::allocator_type allocator_type;
+
+    flat_set(): t(Compare()) {}
+    explicit flat_set(const Compare &c): t(c) {}
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last): t(Compare()) {
+        t.insert_unique(first, last);
+    }
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last, const Compare &c): t(c) {
+        t.insert_unique(first, last);
+    }
+    flat_set(const Compare &c, const allocator_type &a): t(c, a) {}
+    flat_set(const flat_set<Key, Compare, Alloc> &x): t(x.t) {}
+    flat_set<Key, Compare, Alloc> &operator= (const flat_set<Key, Compare, Alloc> &x) {
+        t = x.t;
+        return *this;
+    }
+    flat_set(flat_set<Key, Compare, Alloc> &&x): t(std::move(x.t)) {}
+    flat_set<Key, Compare, Alloc> &operator= (flat_set<Key, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
+    allocator_type get_allocator() const {
+        return t.get_allocator();
+    }
+    key_compare key_comp() const {
+        return t.key_comp();
+    }
+    value_compare value_comp() const {
+        return t.key_comp();
+    }
+    iterator begin() const {
+        return t.begin();
+    }
+    iterator end() const {
+        return t.end();
+    }
+    r_iterator rbegin() const {
+        return t.rbegin();
+    }
+    r_iterator rend() const {
+        return t.rend();
+    }
+    size_type size() const {
+        return t.size();
+    }
+    bool empty() const {
+        return t.empty();
+    }
+    size_type max_size() const {
+        return t.max_size();
+    }
+    size_type capacity() const {
+        return t.capacity();
+    }
+    void reserve(size_type n) {
+        t.reserve(n);
+    }
+    void swap(flat_set<Key, Compare, Alloc> &x) {
+        t.swap(x.t);
+    }
+    hh_std::pair<iterator, bool> insert(const value_type &x) {
+        return t.insert_unique(x);
+    }
+    hh_std::pair<iterator, bool> insert(value_type &&x) {
+        return t.insert_unique(std::move(x));
+    }
+    iterator insert(iterator pos, const value_type &x) {
+        return t.insert_unique(pos, x);
+    }
+    iterator insert(iterator pos, value_type &&x) {
+        return t.insert_unique(pos, std::move(x));
+    }
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace(Args&&... args) {
+        return t.emplace_unique(std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    iterator emplace_hint(iterator pos, Args&&... args) {
+        return t.emplace_hint_unique(pos, std::forward<Args>(args)...);
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_unique(first, last);
+    }
+    iterator erase(iterator pos) {
+        return t.erase(pos);
+    }
+    size_type erase(const key_type &k) {
+        return t.erase(k);
+    }
+    iterator erase(iterator first, iterator last) {
+        return t.erase(first, last);
+    }
+    void clear() {
+        t.clear();
+    }
+    iterator find(const key_type &k) const {
+        return t.find(k);
+    }
+    size_type count(const key_type &k) const {
+        return t.find(k) == t.end() ? 0 : 1;
+    }
+    iterator lower_bound(const key_type &k) const {
+        return t.lower_bound(k);
+    }
+    iterator upper_bound(const key_type &k) const {
+        return t.upper_bound(k);
+    }
+    hh_std::pair<iterator, iterator> equal_range(const key_type &k) const {
+        return t.equal_range(k);
+    }
+    friend bool operator== <> (const flat_set &x, const flat_set &y);
+    friend bool operator< <> (const flat_set &x, const flat_set &y);
+};
+
+template <class Key, class Compare, class Alloc>
+inline void swap(flat_set<Key, Compare, Alloc> &x, flat_set<Key, Compare, Alloc> &y) {
+    x.swap(y);
+}
+
+};
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef __HH_STL_FLAT_TREE_H_
+#define __HH_STL_FLAT_TREE_H_
+
+#include "hh_stl_alloc.h"
+#include "hh_stl_vector.h"
+#include "hh_stl_pair.h"
+#include<cstddef>
+#include<algorithm>
+#include<utility>
+
+namespace hh_std {
+
+// The base of flat_map/flat_set/flat_multimap: the elements sit in one
+// hh_std::vector sorted by key, and lookups are a lower_bound binary search
+// with no node allocation or pointer chasing.  A single insert or erase moves
+// O(n) elements, which suits read-mostly lookup tables; range inserts go
+// through sort + merge.
+template <class Value, class Key, class KeyofValue, class Compare, class Alloc = alloc>
+class flat_tree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef hh_std::vector<Value, Alloc> rep_type;
+    typedef typename rep_type::pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::r_iterator r_iterator;
+    typedef typename rep_type::const_r_iterator const_r_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::allocator_type allocator_type;
+private:
+    // Element-element comparison for sort/merge, and element-key comparisons
+    // for lower_bound/upper_bound.  A set's value_type is its key_type, so the
+    // three live in separate function objects to avoid ambiguous overloads.
+    struct value_key_compare {
+        Compare comp;
+        value_key_compare(const Compare &c): comp(c) {}
+        bool operator() (const value_type &x, const value_type &y) const {
+            return comp(KeyofValue()(x), KeyofValue()(y));
+        }
+    };
+    struct lower_key_compare {
+        Compare comp;
+        lower_key_compare(const Compare &c): comp(c) {}
+        bool operator() (const value_type &x, const key_type &k) const {
+            return comp(KeyofValue()(x), k);
+        }
+    };
+    struct upper_key_compare {
+        Compare comp;
+        upper_key_compare(const Compare &c): comp(c) {}
+        bool operator() (const key_type &k, const value_type &x) const {
+            return comp(k, KeyofValue()(x));
+        }
+    };
+    // In a sorted sequence two neighbours are equivalent iff the first is not less than the second.
+    struct value_equivalent {
+        Compare comp;
+        value_equivalent(const Compare &c): comp(c) {}
+        bool operator() (const value_type &x, const value_type &y) const {
+            return !comp(KeyofValue()(x), KeyofValue()(y));
+        }
+    };
+
+    rep_type c;
+    Compare comp;
+
+    iterator to_iterator(const_iterator pos) {
+        return c.begin() + (pos - c.begin());
+    }
+    const key_type &key(const value_type &x) const {
+        return KeyofValue()(x);
+    }
+    // Whether pos is a valid insert position for k: prev < k < *pos, where
+    // equal allows either neighbour to be equivalent to k.
+    bool hint_fits(const_iterator pos, const key_type &k, bool equal) const {
+        if(pos != c.begin() && (equal ? comp(k, key(*(pos - 1))) : !comp(key(*(pos - 1)), k))) {
+            return false;
+        }
+        return pos == c.end() || (equal ? !comp(key(*pos), k) : comp(k, key(*pos)));
+    }
+    template <class V>
+    hh_std::pair<iterator, bool> __insert_unique(V &&v) {
+        iterator pos = lower_bound(key(v));
+        if(pos != c.end() && !comp(key(v), key(*pos))) {
+            return hh_std::pair<iterator, bool>(pos, false);
+        }
+        return hh_std::pair<iterator, bool>(c.insert(pos, std::forward<V>(v)), true);
+    }
+    template <class V>
+    iterator __insert_unique(const_iterator pos, V &&v) {
+        if(hint_fits(pos, key(v), false)) {
+            return c.insert(to_iterator(pos), std::forward<V>(v));
+        }
+        return __insert_unique(std::forward<V>(v)).first;
+    }
+    template <class V>
+    iterator __insert_equal(V &&v) {
+        return c.insert(upper_bound(key(v)), std::forward<V>(v));
+    }
+    template <class V>
+    iterator __insert_equal(const_iterator pos, V &&v) {
+        if(hint_fits(pos, key(v), true)) {
+            return c.insert(to_iterator(pos), std::forward<V>(v));
+        }
+        return __insert_equal(std::forward<V>(v));
+    }
+    // Appends [first, last), stable-sorts the new run and merges it with the
+    // old one.  Both steps are stable, so among equivalent elements the earlier
+    // ones (old elements first) stay in front.
+    template <class InputIterator>
+    iterator append_sorted(InputIterator first, InputIterator last) {
+        size_type old_size = c.size();
+        c.insert(c.end(), first, last);
+        iterator middle = c.begin() + old_size;
+        value_key_compare vcomp(comp);
+        if(!std::is_sorted(middle, c.end(), vcomp)) {
+            std::stable_sort(middle, c.end(), vcomp);
+        }
+        return middle;
+    }
+public:
+    flat_tree(): comp(Compare()) {}
+    explicit flat_tree(const Compare &cp): comp(cp) {}
+    flat_tree(const Compare &cp, const allocator_type &a): c(a), comp(cp) {}
+    flat_tree(const flat_tree &x): c(x.c), comp(x.comp) {}
+    flat_tree(flat_tree &&x): c(std::move(x.c)), comp(x.comp) {}
+    flat_tree &operator= (const flat_tree &x) {
+        if(this != &x) {
+            c = x.c;
+            comp = x.comp;
+        }
+        return *this;
+    }
+    flat_tree &operator= (flat_tree &&x) {
+        if(this != &x) {
+            c = std::move(x.c);
+            comp = x.comp;
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const {
+        return c.get_allocator();
+    }
+    Compare key_comp() const {
+        return comp;
+    }
+    iterator begin() {
+        return c.begin();
+    }
+    const_iterator begin() const {
+        return c.begin();
+    }
+    iterator end() {
+        return c.end();
+    }
+    const_iterator end() const {
+        return c.end();
+    }
+    r_iterator rbegin() {
+        return c.rbegin();
+    }
+    const_r_iterator rbegin() const {
+        return c.rbegin();
+    }
+    r_iterator rend() {
+        return c.rend();
+    }
+    const_r_iterator rend() const {
+        return c.rend();
+    }
+    size_type size() const {
+        return c.size();
+    }
+    bool empty() const {
+        return c.empty();
+    }
+    size_type max_size() const {
+        return c.max_size();
+    }
+    size_type capacity() const {
+        return c.capacity();
+    }
+    void reserve(size_type n) {
+        c.reserve(n);
+    }
+    reference operator[] (size_type n) {
+        return c[n];
+    }
+    const_reference operator[] (size_type n) const {
+        return c[n];
+    }
+    void swap(flat_tree &x) {
+        c.swap(x.c);
+        std::swap(comp, x.comp);
+    }
+
+    hh_std::pair<iterator, bool> insert_unique(const value_type &v) {
+        return __insert_unique(v);
+    }
+    hh_std::pair<iterator, bool> insert_unique(value_type &&v) {
+        return __insert_unique(std::move(v));
+    }
+    iterator insert_unique(const_iterator pos, const value_type &v) {
+        return __insert_unique(pos, v);
+    }
+    iterator insert_unique(const_iterator pos, value_type &&v) {
+        return __insert_unique(pos, std::move(v));
+    }
+    iterator insert_equal(const value_type &v) {
+        return __insert_equal(v);
+    }
+    iterator insert_equal(value_type &&v) {
+        return __insert_equal(std::move(v));
+    }
+    iterator insert_equal(const_iterator pos, const value_type &v) {
+        return __insert_equal(pos, v);
+    }
+    iterator insert_equal(const_iterator pos, value_type &&v) {
+        return __insert_equal(pos, std::move(v));
+    }
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace_unique(Args&&... args) {
+        return __insert_unique(value_type(std::forward<Args>(args)...));
+    }
+    template <class... Args>
+    iterator emplace_hint_unique(const_iterator pos, Args&&... args) {
+        return __insert_unique(pos, value_type(std::forward<Args>(args)...));
+    }
+    template <class... Args>
+    iterator emplace_equal(Args&&... args) {
+        return __insert_equal(value_type(std::forward<Args>(args)...));
+    }
+    template <class... Args>
+    iterator emplace_hint_equal(const_iterator pos, Args&&... args) {
+        return __insert_equal(pos, value_type(std::forward<Args>(args)...));
+    }
+    // Range insert: one sort and one inplace_merge instead of n O(n) single inserts.
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last) {
+        iterator middle = append_sorted(first, last);
+        value_key_compare vcomp(comp);
+        std::inplace_merge(c.begin(), middle, c.end(), vcomp);
+        c.erase(std::unique(c.begin(), c.end(), value_equivalent(comp)), c.end());
+    }
+    template <class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last) {
+        iterator middle = append_sorted(first, last);
+        std::inplace_merge(c.begin(), middle, c.end(), value_key_compare(comp));
+    }
+
+    iterator erase(const_iterator pos) {
+        return c.erase(to_iterator(pos));
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        return c.erase(to_iterator(first), to_iterator(last));
+    }
+    size_type erase(const key_type &k) {
+        hh_std::pair<iterator, iterator> range = equal_range(k);
+        size_type n = range.second - range.first;
+        if(n != 0) {
+            c.erase(range.first, range.second);
+        }
+        return n;
+    }
+    void clear() {
+        c.clear();
+    }
+
+    iterator lower_bound(const key_type &k) {
+        return std::lower_bound(c.begin(), c.end(), k, lower_key_compare(comp));
+    }
+    const_iterator lower_bound(const key_type &k) const {
+        return std::lower_bound(c.begin(), c.end(), k, lower_key_compare(comp));
+    }
+    iterator upper_bound(const key_type &k) {
+        return std::upper_bound(c.begin(), c.end(), k, upper_key_compare(comp));
+    }
+    const_iterator upper_bound(const key_type &k) const {
+        return std::upper_bound(c.begin(), c.end(), k, upper_key_compare(comp));
+    }
+    hh_std::pair<iterator, iterator> equal_range(const key_type &k) {
+        iterator first = lower_bound(k);
+        iterator last = std::upper_bound(first, c.end(), k, upper_key_compare(comp));
+        return hh_std::pair<iterator, iterator>(first, last);
+    }
+    hh_std::pair<const_iterator, const_iterator> equal_range(const key_type &k) const {
+        const_iterator first = lower_bound(k);
+        const_iterator last = std::upper_bound(first, c.end(), k, upper_key_compare(comp));
+        return hh_std::pair<const_iterator, const_iterator>(first, last);
+    }
+    iterator find(const key_type &k) {
+        iterator pos = lower_bound(k);
+        return (pos == c.end() || comp(k, key(*pos))) ? c.end() : pos;
+    }
+    const_iterator find(const key_type &k) const {
+        const_iterator pos = lower_bound(k);
+        return (pos == c.end() || comp(k, key(*pos))) ? c.end() : pos;
+    }
+    size_type count(const key_type &k) const {
+        hh_std::pair<const_iterator, const_iterator> range = equal_range(k);
+        return range.second - range.first;
+    }
+};
+
+template <class Value, class Key, class KeyofValue, class Compare, class Alloc>
+inline bool operator== (const flat_tree<Value, Key, KeyofValue, Compare, Alloc> &x, const flat_tree<Value, Key, KeyofValue, Compare, Alloc> &y) {
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template <class Value, class Key, class KeyofValue, class Compare, class Alloc>
+inline bool operator< (const flat_tree<Value, Key, KeyofValue, Compare, Alloc> &x, const flat_tree<Value, Key, KeyofValue, Compare, Alloc> &y) {
+    return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+
+template <class Value, class Key, class KeyofValue, class Compare, class Alloc>
+inline void swap(flat_tree<Value, Key, KeyofValue, Compare, Alloc> &x, flat_tree<Value, Key, KeyofValue, Compare, Alloc> &y) {
+    x.swap(y);
+}
+
+};
+
+#endif
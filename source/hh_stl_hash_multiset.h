@@ -38,6 +38,7 @@ public:
 
     typedef typename rep_type::const_iterator iterator;
     typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::allocator_type allocator_type;
 
     hasher hash_fun() const {
         return hasher();
@@ -51,6 +52,7 @@ public:
     explicit hash_multiset(const size_type n): ht(n, hash_fun(), eq_fun()) {}
     hash_multiset(const size_type n, const hasher &h): ht(n, h, eq_fun()) {}
     hash_multiset(const size_type n, const hasher &h, const equals &e): ht(n, h, e) {}
+    hash_multiset(const size_type n, const hasher &h, const equals &e, const allocator_type &a): ht(n, h, e, a) {}
 
     template <class InputIterator>
     hash_multiset(InputIterator first, InputIterator last): ht(50, hash_fun(), eq_fun()) {
@@ -68,6 +70,9 @@ public:
     hash_multiset(InputIterator first, InputIterator last, const size_type n, const hasher &h, const equals &e): ht(n, h, e) {
         ht.insert_equal(first, last);
     }
+    allocator_type get_allocator() const {
+        return ht.get_allocator();
+    }
     size_type size() const {
         return ht.size();
     }
@@ -90,10 +95,23 @@ public:
         typename rep_type::iterator result = ht.insert_equal(x);
         return iterator(result.cur, result.table);
     }
+    iterator insert(value_type &&x) {
+        typename rep_type::iterator result = ht.insert_equal(std::move(x));
+        return iterator(result.cur, result.table);
+    }
     iterator insert_noresize(const value_type &x) {
         typename rep_type::iterator result = ht.insert_equal_noresize(x);
         return iterator(result.cur, result.table);
     }
+    iterator insert_noresize(value_type &&x) {
+        typename rep_type::iterator result = ht.insert_equal_noresize(std::move(x));
+        return iterator(result.cur, result.table);
+    }
+    template <class... Args>
+    iterator emplace(Args&&... args) {
+        typename rep_type::iterator result = ht.emplace_equal(std::forward<Args>(args)...);
+        return iterator(result.cur, result.table);
+    }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
         ht.insert_equal(first, last);
@@ -37,6 +37,7 @@ public:
     typedef typename rep_type::difference_type difference_type;
     typedef typename rep_type::iterator iterator;
     typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::allocator_type allocator_type;
 
     hasher hash_fun() const {
         return hasher();
@@ -49,6 +50,7 @@ public:
     explicit hash_map(const size_type n): ht(n, hash_fun(), key_eq()) {}
     hash_map(const size_type n, const hasher &h): ht(n, h, key_eq()) {}
     hash_map(const size_type n, const hasher &h, const key_equal &k): ht(n, h, k) {}
+    hash_map(const size_type n, const hasher &h, const key_equal &k, const allocator_type &a): ht(n, h, k, a) {}
 
     template <class InputIterator>
     hash_map(InputIterator first, InputIterator last): ht(50, hash_fun(), key_eq()) {
@@ -67,6 +69,9 @@ public:
         ht.insert_unique(first, last);
     }
 
+    allocator_type get_allocator() const {
+        return ht.get_allocator();
+    }
     size_type size() const {
         return ht.size();
     }
@@ -94,12 +99,25 @@ public:
     data_type &operator[] (const key_type &k) {
         return ht.find_or_insert(value_type(k, T())).second;
     }
+    data_type &operator[] (key_type &&k) {
+        return ht.find_or_insert(value_type(std::move(k), T())).second;
+    }
     hh_std::pair<iterator, bool> insert(const value_type &x) {
         return ht.insert_unique(x);
     }
+    hh_std::pair<iterator, bool> insert(value_type &&x) {
+        return ht.insert_unique(std::move(x));
+    }
     hh_std::pair<iterator, bool> insert_noresize(const value_type &x) {
         return ht.insert_unique_noresize(x);
     }
+    hh_std::pair<iterator, bool> insert_noresize(value_type &&x) {
+        return ht.insert_unique_noresize(std::move(x));
+    }
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace(Args&&... args) {
+        return ht.emplace_unique(std::forward<Args>(args)...);
+    }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
         ht.insert_unique(first, last);
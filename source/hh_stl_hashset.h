@@ -38,6 +38,7 @@ public:
 
     typedef typename rep_type::const_iterator iterator;
     typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::allocator_type allocator_type;
 
     hasher hash_fun() const {
         return hasher();
@@ -51,6 +52,7 @@ public:
     explicit hash_set(const size_type n): ht(n, hash_fun(), eq_fun()) {}
     hash_set(const size_type n, const hasher &h): ht(n, h, eq_fun()) {}
     hash_set(const size_type n, const hasher &h, const equals &e): ht(n, h, e) {}
+    hash_set(const size_type n, const hasher &h, const equals &e, const allocator_type &a): ht(n, h, e, a) {}
 
     template <class InputIterator>
     hash_set(InputIterator first, InputIterator last): ht(50, hash_fun(), eq_fun()) {
@@ -68,6 +70,9 @@ public:
     hash_set(InputIterator first, InputIterator last, const size_type n, const hasher &h, const equals &e): ht(n, h, e) {
         ht.insert_unique(first, last);
     }
+    allocator_type get_allocator() const {
+        return ht.get_allocator();
+    }
     size_type size() const {
         return ht.size();
     }
@@ -90,10 +95,23 @@ public:
         hh_std::pair<typename rep_type::iterator, bool> result = ht.insert_unique(x);
         return hh_std::make_pair(iterator(result.first.cur, result.first.table), result.second);
     }
+    hh_std::pair<iterator, bool> insert(value_type &&x) {
+        hh_std::pair<typename rep_type::iterator, bool> result = ht.insert_unique(std::move(x));
+        return hh_std::make_pair(iterator(result.first.cur, result.first.table), result.second);
+    }
     hh_std::pair<iterator, bool> insert_noresize(const value_type &x) {
         hh_std::pair<typename rep_type::iterator, bool> result = ht.insert_unique_noresize(x);
         return hh_std::make_pair(iterator(result.first.cur, result.first.table), result.second);
     }
+    hh_std::pair<iterator, bool> insert_noresize(value_type &&x) {
+        hh_std::pair<typename rep_type::iterator, bool> result = ht.insert_unique_noresize(std::move(x));
+        return hh_std::make_pair(iterator(result.first.cur, result.first.table), result.second);
+    }
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace(Args&&... args) {
+        hh_std::pair<typename rep_type::iterator, bool> result = ht.emplace_unique(std::forward<Args>(args)...);
+        return hh_std::make_pair(iterator(result.first.cur, result.first.table), result.second);
+    }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
         ht.insert_unique(first, last);
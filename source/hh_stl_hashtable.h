@@ -8,6 +8,7 @@
 #include "hh_stl_construct.h"
 #include "hh_stl_pair.h"
 #include "hh_stl_hash_fun.h"
+#include<utility>
 
 namespace hh_std {
 
@@ -126,7 +127,7 @@ public:
         return *this;
     }
     const_iterator operator++ (int) {
-        iterator tmp = *this;
+        const_iterator tmp = *this;
         ++*this;
         return tmp;
     }
@@ -169,12 +170,12 @@ inline bool operator== (const hashtable<Key, Value, KeyofValue, HashFun, EqualFu
 }
 
 template <class Key, class Value, class KeyofValue, class HashFun, class EqualFun, class Alloc = alloc>
-inline void swap (const hashtable<Key, Value, KeyofValue, HashFun, EqualFun, Alloc> &x, const hashtable<Key, Value, KeyofValue, HashFun, EqualFun, Alloc> &y) {
+inline void swap (hashtable<Key, Value, KeyofValue, HashFun, EqualFun, Alloc> &x, hashtable<Key, Value, KeyofValue, HashFun, EqualFun, Alloc> &y) {
     x.swap(y);
 }
 
 template <class Key, class Value, class KeyofValue, class HashFun, class EqualFun, class Alloc = alloc>
-struct hashtable {
+struct hashtable: private __alloc_holder<Alloc> {
 public:
     typedef Key key_type;
     typedef Value value_type;
@@ -187,6 +188,7 @@ public:
     typedef const value_type& const_reference;
     typedef ptrdiff_t difference_type;
     typedef size_t size_type;
+    typedef Alloc allocator_type;
 
     hasher hash_func() const {
         return hasher();
@@ -201,6 +203,7 @@ private:
     KeyofValue kov;
 
     typedef __hashtable_node<Value> node;
+    typedef __alloc_holder<Alloc> alloc_base;
     typedef hh_std::simple_alloc<node, Alloc> node_allocater;
 
     hh_std::vector<node*, Alloc> buckets;
@@ -212,18 +215,30 @@ public:
     friend iterator;
     friend const_iterator;
 
-    hashtable(size_type n, const KeyofValue &k, const HashFun &h, const EqualFun &e): kov(k), hash(h), equals(e) {
+    hashtable(size_type n, const KeyofValue &k, const HashFun &h, const EqualFun &e,
+              const allocator_type &a = allocator_type()):
+        alloc_base(a), hash(h), equals(e), kov(k), buckets(a) {
         initialize_buckets(n);
     }
-    hashtable(size_type n, const HashFun &h, const EqualFun &e): kov(KeyofValue()), hash(h), equals(e) {
+    hashtable(size_type n, const HashFun &h, const EqualFun &e,
+              const allocator_type &a = allocator_type()):
+        alloc_base(a), hash(h), equals(e), kov(KeyofValue()), buckets(a) {
         initialize_buckets(n);
     }
-    hashtable(const hashtable &h): kov(h.kov), hash(h.hash), equals(h.equals), num_elements(0) {
+    hashtable(const hashtable &h):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(h.get_alloc())),
+        hash(h.hash), equals(h.equals), kov(h.kov), buckets(this->get_alloc()), num_elements(0) {
         copy_from(h);
     }
+    hashtable(hashtable &&h):
+        alloc_base(h.get_alloc()), hash(h.hash), equals(h.equals), kov(h.kov), buckets(this->get_alloc()) {
+        initialize_buckets(0);
+        swap_data(h);
+    }
     hashtable &operator= (const hashtable &h) {
         if(this != &h) {
             clear();
+            copy_assign_alloc(h, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
             hash = h.hash;
             equals = h.equals;
             kov = h.kov;
@@ -231,6 +246,12 @@ public:
         }
         return *this;
     }
+    hashtable &operator= (hashtable &&h) {
+        if(this != &h) {
+            move_assign(h, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
     ~hashtable() {
         clear();
     }
@@ -243,12 +264,13 @@ public:
     bool empty() const {
         return num_elements == 0;
     }
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
     void swap(hashtable &h) {
-        swap(kov, h.kov);
-        swap(equals, h.equals);
-        swap(hash, h, hash);
-        swap(num_elements, h.num_elements);
-        swap(buckets, h.buckets);
+        __alloc_swap(this->get_alloc(), h.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        swap_data(h);
     }
     iterator begin() {
         for(size_type i = 0; i < buckets.size(); ++i) {
@@ -287,44 +309,42 @@ public:
     }
     hh_std::pair<iterator, bool> insert_unique(const value_type &x) {
         resize(num_elements + 1);
-        return insert_unique_noresize(x);
+        return __insert_unique_noresize(x);
+    }
+    hh_std::pair<iterator, bool> insert_unique(value_type &&x) {
+        resize(num_elements + 1);
+        return __insert_unique_noresize(std::move(x));
     }
     hh_std::pair<iterator, bool> insert_unique_noresize(const value_type &x) {
-        size_type pos = bkt_num(x);
-        node *cur = buckets[pos];
-        while(cur) {
-            if(equals(kov(cur->data), kov(x))) {
-                return hh_std::make_pair(iterator(cur, this), false);
-            }
-            cur = cur->next;
-        }
-        node *new_node = create_node(x);
-        new_node->next = buckets[pos];
-        buckets[pos] = new_node;
-        ++num_elements;
-        return hh_std::make_pair(iterator(new_node, this), true);
+        return __insert_unique_noresize(x);
+    }
+    hh_std::pair<iterator, bool> insert_unique_noresize(value_type &&x) {
+        return __insert_unique_noresize(std::move(x));
     }
     iterator insert_equal(const value_type &x) {
         resize(num_elements + 1);
-        return insert_equal_noresize(x);
+        return __insert_equal_noresize(x);
+    }
+    iterator insert_equal(value_type &&x) {
+        resize(num_elements + 1);
+        return __insert_equal_noresize(std::move(x));
     }
     iterator insert_equal_noresize(const value_type &x) {
-        size_type pos = bkt_num(x);
-        node *cur = buckets[pos];
-        node *new_node = create_node(x);
-        while(cur) {
-            if(equals(kov(cur->data), kov(x))) {
-                new_node->next = cur->next;
-                cur->next = new_node;
-                ++num_elements;
-                return iterator(new_node, this);
-            }
-            cur = cur->next;
-        }
-        new_node->next = buckets[pos];
-        buckets[pos] = new_node;
-        ++num_elements;
-        return iterator(new_node, this);
+        return __insert_equal_noresize(x);
+    }
+    iterator insert_equal_noresize(value_type &&x) {
+        return __insert_equal_noresize(std::move(x));
+    }
+    // emplace builds the element in a node first, then links it by its key.
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace_unique(Args&&... args) {
+        resize(num_elements + 1);
+        return link_unique(create_node(std::forward<Args>(args)...));
+    }
+    template <class... Args>
+    iterator emplace_equal(Args&&... args) {
+        resize(num_elements + 1);
+        return link_equal(create_node(std::forward<Args>(args)...));
     }
     template <class InputIterator>
     void insert_unique(InputIterator first, InputIterator last) {
@@ -343,7 +363,7 @@ public:
     }
     template <class InputIterator>
     void insert_unique(InputIterator first, InputIterator last, forward_iterator_tag) {
-        size_type n = distance(first, last);
+        size_type n = hh_std::distance(first, last);
         resize(num_elements + n);
         while(first != last) {
             insert_unique_noresize(*first);
@@ -359,7 +379,7 @@ public:
     }
     template <class InputIterator>
     void insert_equal(InputIterator first, InputIterator last, forward_iterator_tag) {
-        size_type n = distance(first, last);
+        size_type n = hh_std::distance(first, last);
         resize(num_elements + n);
         while(first != last) {
             insert_equal_noresize(*first);
@@ -394,9 +414,10 @@ public:
         node *cur = buckets[pos];
         while(cur) {
             if(equals(kov(cur->data), k))
-                return iterator(cur, this);
+                return const_iterator(cur, this);
+            cur = cur->next;
         }
-        return iterator(cur, this);
+        return const_iterator(cur, this);
     }
     size_type count(const key_type &k) const {
         size_type pos = bkt_num_key(k);
@@ -409,14 +430,17 @@ public:
         }
         return result;
     }
-    reference find_or_insert(const value_type &x) {
+    template <class V>
+    reference find_or_insert(V &&x) {
+        resize(num_elements + 1);
         size_type pos = bkt_num(x);
         node *cur = buckets[pos];
         while(cur) {
             if(equals(kov(cur->data), kov(x)))
                 return cur->data;
+            cur = cur->next;
         }
-        node *new_node = create_node(x);
+        node *new_node = create_node(std::forward<V>(x));
         new_node->next = buckets[pos];
         buckets[pos] = new_node;
         ++num_elements;
@@ -602,7 +626,7 @@ private:
         if(n > buckets.size()) {
             size_type new_size = __stl_next_prime(n);
             if(new_size >= n) {
-                vector<node*, Alloc> tmp(new_size, (node*)0);
+                vector<node*, Alloc> tmp(new_size, (node*)0, this->get_alloc());
                 for(size_type i = 0; i < buckets.size(); ++i) {
                     node *first = buckets[i];
                     while(first) {
@@ -629,19 +653,103 @@ private:
     size_type bkt_num_key(const key_type&x, size_type n) const {
         return hash(x) % n;
     }
-    node* create_node(const value_type &x) {
-        node* new_node;
+    template <class... Args>
+    node* create_node(Args&&... args) {
+        node* new_node = node_allocater::allocate(this->get_alloc());
         __STL_TRY {
-            new_node = node_allocater::allocate();
-            construct(&(new_node->data), x);
+            construct(&(new_node->data), std::forward<Args>(args)...);
             new_node->next = 0;
         }
-        __STL_UNWIND(destroy_node(new_node))
+        __STL_UNWIND(node_allocater::deallocate(this->get_alloc(), new_node))
         return new_node;
     }
     void destroy_node(node* n) {
         destory(&(n->data));
-        node_allocater::deallocate(n);
+        node_allocater::deallocate(this->get_alloc(), n);
+    }
+    void copy_assign_alloc(const hashtable &h, __true_type) {
+        this->get_alloc() = h.get_alloc();
+        buckets = vector<node*, Alloc>(this->get_alloc());
+    }
+    void copy_assign_alloc(const hashtable &, __false_type) {
+    }
+    void swap_data(hashtable &h) {
+        std::swap(kov, h.kov);
+        std::swap(equals, h.equals);
+        std::swap(hash, h.hash);
+        std::swap(num_elements, h.num_elements);
+        buckets.swap(h.buckets);
+    }
+    void move_assign(hashtable &h, __true_type) {
+        clear();
+        swap_data(h);
+        __alloc_swap(this->get_alloc(), h.get_alloc(), __true_type());
+    }
+    void move_assign(hashtable &h, __false_type) {
+        clear();
+        hash = h.hash;
+        equals = h.equals;
+        kov = h.kov;
+        resize(h.num_elements);
+        for(size_type i = 0; i < h.buckets.size(); ++i) {
+            for(node *cur = h.buckets[i]; cur; cur = cur->next) {
+                insert_equal_noresize(std::move(cur->data));
+            }
+        }
+        h.clear();
+    }
+    template <class V>
+    hh_std::pair<iterator, bool> __insert_unique_noresize(V &&x) {
+        size_type pos = bkt_num(x);
+        node *cur = buckets[pos];
+        while(cur) {
+            if(equals(kov(cur->data), kov(x))) {
+                return hh_std::make_pair(iterator(cur, this), false);
+            }
+            cur = cur->next;
+        }
+        node *new_node = create_node(std::forward<V>(x));
+        new_node->next = buckets[pos];
+        buckets[pos] = new_node;
+        ++num_elements;
+        return hh_std::make_pair(iterator(new_node, this), true);
+    }
+    template <class V>
+    iterator __insert_equal_noresize(V &&x) {
+        return link_equal(create_node(std::forward<V>(x)));
+    }
+    // Links an already built node; destroys it if the key is already present.
+    hh_std::pair<iterator, bool> link_unique(node *new_node) {
+        size_type pos = bkt_num(new_node->data);
+        node *cur = buckets[pos];
+        while(cur) {
+            if(equals(kov(cur->data), kov(new_node->data))) {
+                destroy_node(new_node);
+                return hh_std::make_pair(iterator(cur, this), false);
+            }
+            cur = cur->next;
+        }
+        new_node->next = buckets[pos];
+        buckets[pos] = new_node;
+        ++num_elements;
+        return hh_std::make_pair(iterator(new_node, this), true);
+    }
+    iterator link_equal(node *new_node) {
+        size_type pos = bkt_num(new_node->data);
+        node *cur = buckets[pos];
+        while(cur) {
+            if(equals(kov(cur->data), kov(new_node->data))) {
+                new_node->next = cur->next;
+                cur->next = new_node;
+                ++num_elements;
+                return iterator(new_node, this);
+            }
+            cur = cur->next;
+        }
+        new_node->next = buckets[pos];
+        buckets[pos] = new_node;
+        ++num_elements;
+        return iterator(new_node, this);
     }
     void initialize_buckets(size_type n) {
         n = __stl_next_prime(n);
@@ -650,8 +758,9 @@ private:
         num_elements = 0;
     }
     void copy_from(const hashtable &h) {
+        buckets.clear();
         buckets.reserve(h.buckets.size());
-        buckets.insert(buckets.end(), buckets.size(), (node*)0);
+        buckets.insert(buckets.end(), h.buckets.size(), (node*)0);
         node *new_node;
         for(size_type i = 0; i < h.buckets.size(); ++i) {
             if(const node* cur = h.buckets[i]) {
@@ -661,6 +770,7 @@ private:
                 while(cur) {
                     new_node->next = create_node(cur->data);
                     new_node = new_node->next;
+                    cur = cur->next;
                 }
             }
         }
@@ -2,6 +2,7 @@
 #define __HH_STL_HEAP_H_
 
 #include "hh_stl_iterator.h"
+#include<utility>
 
 namespace hh_std {
 
@@ -10,13 +11,13 @@ void __push_heap(RandomAccessIterator first, RandomAccessIterator last, Distance
     if ((last - first) < 2) return;
     Distance hole_index = (last - first) - 1;
     Distance parent_index = (hole_index - 1) / 2;
-    T value = *(last - 1);
+    T value = std::move(*(last - 1));
     while(hole_index > 0 && *(first + parent_index) < value) {
-        *(first + hole_index) = *(first + parent_index);
+        *(first + hole_index) = std::move(*(first + parent_index));
         hole_index = parent_index;
         parent_index = (hole_index - 1) / 2;
     }
-    *(first + hole_index) = value;
+    *(first + hole_index) = std::move(value);
 }
 
 template <class RandomAccessIterator>
@@ -29,13 +30,13 @@ void __push_heap(RandomAccessIterator first, RandomAccessIterator last, Distance
     if ((last - first) < 2) return;
     Distance hole_index = (last - first) - 1;
     Distance parent_index = (hole_index - 1) / 2;
-    T value = *(last - 1);
-    while(hole_index > 0 && comp(*(first + parent_index)), value) {
-        *(first + hole_index) = *(first + parent_index);
+    T value = std::move(*(last - 1));
+    while(hole_index > 0 && comp(*(first + parent_index), value)) {
+        *(first + hole_index) = std::move(*(first + parent_index));
         hole_index = parent_index;
         parent_index = (hole_index - 1) / 2;
     }
-    *(first + hole_index) = value;
+    *(first + hole_index) = std::move(value);
 }
 
 template <class RandomAccessIterator, class Compare>
@@ -46,8 +47,8 @@ void push_heap(RandomAccessIterator first, RandomAccessIterator last, Compare co
 template <class RandomAccessIterator, class Distance, class T>
 void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, Distance*, T*) {
     if ((last - first) < 2) return;
-    T value = *(last - 1);
-    *(last - 1) = *(first);
+    T value = std::move(*(last - 1));
+    *(last - 1) = std::move(*(first));
     Distance len = (last - first) - 1;
     Distance hole_index = 0;
     Distance next_index = hole_index * 2 + 2;
@@ -56,7 +57,7 @@ void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, Distance*
             next_index -= 1;
         }
         if(*(first + next_index) > value) {
-            *(first + hole_index) = *(first + next_index);
+            *(first + hole_index) = std::move(*(first + next_index));
             hole_index = next_index;
             next_index = 2 * hole_index + 2;
         } else {
@@ -64,10 +65,10 @@ void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, Distance*
         }
     }
     if(next_index == len && *(first + next_index - 1) > value) {
-        *(first + hole_index) = *(first + next_index - 1);
+        *(first + hole_index) = std::move(*(first + next_index - 1));
         hole_index = next_index - 1;
     }
-    *(first + hole_index) = value;
+    *(first + hole_index) = std::move(value);
 }
 
 template <class RandomAccessIterator>
@@ -78,8 +79,8 @@ void pop_heap(RandomAccessIterator first, RandomAccessIterator last) {
 template <class RandomAccessIterator, class Distance, class T, class Compare>
 void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, Distance*, T*, Compare comp) {
     if ((last - first) < 2) return;
-    T value = *(last - 1);
-    *(last - 1) = *(first);
+    T value = std::move(*(last - 1));
+    *(last - 1) = std::move(*(first));
     Distance len = (last - first) - 1;
     Distance hole_index = 0;
     Distance next_index = hole_index * 2 + 2;
@@ -88,7 +89,7 @@ void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, Distance*
             next_index -= 1;
         }
         if(comp(value, *(first + next_index))) {
-            *(first + hole_index) = *(first + next_index);
+            *(first + hole_index) = std::move(*(first + next_index));
             hole_index = next_index;
             next_index = 2 * hole_index + 2;
         } else {
@@ -96,10 +97,10 @@ void __pop_heap(RandomAccessIterator first, RandomAccessIterator last, Distance*
         }
     }
     if(next_index == len && comp(value, *(first + next_index - 1))) {
-        *(first + hole_index) = *(first + next_index - 1);
+        *(first + hole_index) = std::move(*(first + next_index - 1));
         hole_index = next_index - 1;
     }
-    * (first + hole_index) = value;
+    * (first + hole_index) = std::move(value);
 }
 
 template <class RandomAccessIterator, class Compare>
@@ -110,13 +111,13 @@ void pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare com
 template <class RandomAccessIterator, class Distance, class T>
 void __adjust_heap(RandomAccessIterator first, Distance len, Distance hole_index,  Distance*, T*) {
     Distance next_index = hole_index * 2 + 2;
-    T value = *(first + hole_index);
+    T value = std::move(*(first + hole_index));
     while(next_index < len) {
         if(*(first + next_index) < * (first + next_index - 1)) {
             next_index--;
         }
         if(*(first + next_index) > value) {
-            *(first + hole_index) = *(first + next_index);
+            *(first + hole_index) = std::move(*(first + next_index));
             hole_index = next_index;
             next_index = hole_index * 2 + 2;
         } else {
@@ -124,22 +125,22 @@ void __adjust_heap(RandomAccessIterator first, Distance len, Distance hole_index
         }
     }
     if(next_index == len && *(first + next_index - 1) > value) {
-        *(first + hole_index) = *(first + next_index - 1);
+        *(first + hole_index) = std::move(*(first + next_index - 1));
         hole_index = next_index - 1;
     }
-    *(first + hole_index) = value;
+    *(first + hole_index) = std::move(value);
 }
 
 template <class RandomAccessIterator, class Distance, class T, class Compare>
 void __adjust_heap(RandomAccessIterator first, Distance len, Distance hole_index, Distance*, T*, Compare comp) {
     Distance next_index = hole_index * 2 + 2;
-    T value = *(first + hole_index);
+    T value = std::move(*(first + hole_index));
     while(next_index < len) {
         if(comp(*(first + next_index), *(first + next_index - 1))) {
             next_index--;
         }
         if(comp(value, *(first + next_index))) {
-            *(first + hole_index) = *(first + next_index);
+            *(first + hole_index) = std::move(*(first + next_index));
             hole_index = next_index;
             next_index = hole_index * 2 + 2;
         } else {
@@ -147,10 +148,10 @@ void __adjust_heap(RandomAccessIterator first, Distance len, Distance hole_index
         }
     }
     if(next_index == len && comp(value, *(first + next_index - 1))) {
-        *(first + hole_index) = *(first + next_index - 1);
+        *(first + hole_index) = std::move(*(first + next_index - 1));
         hole_index = next_index - 1;
     }
-    *(first + hole_index) = value;
+    *(first + hole_index) = std::move(value);
 }
 
 template <class RandomAccessIterator, class Distance, class T>
@@ -0,0 +1,316 @@
+#ifndef __HH_STL_INTRUSIVE_LIST_H_
+#define __HH_STL_INTRUSIVE_LIST_H_
+
+#include<cstddef>
+#include<cassert>
+#include<utility>
+#include "hh_stl_iterator.h"
+
+namespace hh_std {
+
+// A doubly linked list of objects that carry their own links.  T derives from
+// intrusive_list_hook<Tag>; the list never allocates, copies or destroys a T,
+// it only links and unlinks the hooks, all in O(1).  An object can be in one
+// list per Tag at a time.
+//
+// An unlinked hook has null links, so is_linked() is exact.  Linking a hook
+// that is already linked, or destroying one that still is, trips an assert.
+
+struct __list_node_base {
+    __list_node_base *prev;
+    __list_node_base *next;
+};
+
+template <class Tag = void>
+class intrusive_list_hook: public __list_node_base {
+public:
+    intrusive_list_hook() {
+        prev = next = 0;
+    }
+    // Copying an object does not copy its membership.
+    intrusive_list_hook(const intrusive_list_hook&) {
+        prev = next = 0;
+    }
+    intrusive_list_hook &operator= (const intrusive_list_hook&) {
+        return *this;
+    }
+    ~intrusive_list_hook() {
+        assert(!is_linked() && "object destroyed while still in an intrusive_list");
+    }
+    bool is_linked() const {
+        return next != 0;
+    }
+    // Removes the object from whatever list holds it, without the list.
+    void unlink() {
+        if(is_linked()) {
+            prev->next = next;
+            next->prev = prev;
+            prev = next = 0;
+        }
+    }
+};
+
+template <class T, class Tag, class Ref, class Ptr>
+struct __intrusive_list_iterator {
+    typedef __intrusive_list_iterator<T, Tag, T&, T*> iterator;
+    typedef __intrusive_list_iterator<T, Tag, const T&, const T*> const_iterator;
+    typedef __intrusive_list_iterator self;
+    typedef intrusive_list_hook<Tag> hook_type;
+
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    __list_node_base *node;
+
+    explicit __intrusive_list_iterator(__list_node_base *x): node(x) {}
+    __intrusive_list_iterator(): node(0) {}
+    __intrusive_list_iterator(const iterator &x): node(x.node) {}
+
+    reference operator* () const {
+        return *static_cast<T*>(static_cast<hook_type*>(node));
+    }
+    pointer operator-> () const {
+        return &(operator*());
+    }
+    self &operator++ () {
+        node = node->next;
+        return *this;
+    }
+    self operator++ (int) {
+        self tmp = *this;
+        node = node->next;
+        return tmp;
+    }
+    self &operator-- () {
+        node = node->prev;
+        return *this;
+    }
+    self operator-- (int) {
+        self tmp = *this;
+        node = node->prev;
+        return tmp;
+    }
+    bool operator== (const self &x) const {
+        return node == x.node;
+    }
+    bool operator!= (const self &x) const {
+        return node != x.node;
+    }
+};
+
+template <class T, class Tag = void>
+class intrusive_list {
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef intrusive_list_hook<Tag> hook_type;
+    typedef __intrusive_list_iterator<T, Tag, T&, T*> iterator;
+    typedef __intrusive_list_iterator<T, Tag, const T&, const T*> const_iterator;
+    typedef reverse_iterator<const_iterator> const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+protected:
+    // Circular, with the header in the container like list's node.
+    __list_node_base header;
+
+    void empty_initialize() {
+        header.prev = header.next = &header;
+    }
+    static __list_node_base *hook_of(T &x) {
+        return static_cast<hook_type*>(&x);
+    }
+    static void link_before(__list_node_base *pos, __list_node_base *x) {
+        x->next = pos;
+        x->prev = pos->prev;
+        pos->prev->next = x;
+        pos->prev = x;
+    }
+    static void unlink_node(__list_node_base *x) {
+        x->prev->next = x->next;
+        x->next->prev = x->prev;
+        x->prev = x->next = 0;
+    }
+    // Moves [first, last) in front of pos.
+    static void transfer(__list_node_base *pos, __list_node_base *first, __list_node_base *last) {
+        if(pos != last && pos != first) {
+            __list_node_base *tail = last->prev;
+            first->prev->next = last;
+            last->prev = first->prev;
+            first->prev = pos->prev;
+            tail->next = pos;
+            pos->prev->next = first;
+            pos->prev = tail;
+        }
+    }
+    // Takes over x's elements; *this must be empty.
+    void steal(intrusive_list &x) {
+        if(x.empty()) {
+            empty_initialize();
+        } else {
+            header = x.header;
+            header.next->prev = &header;
+            header.prev->next = &header;
+            x.empty_initialize();
+        }
+    }
+public:
+    intrusive_list() {
+        empty_initialize();
+    }
+    intrusive_list(const intrusive_list&) = delete;
+    intrusive_list &operator= (const intrusive_list&) = delete;
+    intrusive_list(intrusive_list &&x) {
+        steal(x);
+    }
+    intrusive_list &operator= (intrusive_list &&x) {
+        if(&x != this) {
+            clear();
+            steal(x);
+        }
+        return *this;
+    }
+    // Unlinks the elements; they are not destroyed.
+    ~intrusive_list() {
+        clear();
+    }
+
+    iterator begin() {
+        return iterator(header.next);
+    }
+    const_iterator begin() const {
+        return const_iterator(iterator(const_cast<__list_node_base*>(header.next)));
+    }
+    iterator end() {
+        return iterator(&header);
+    }
+    const_iterator end() const {
+        return const_iterator(iterator(const_cast<__list_node_base*>(&header)));
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    bool empty() const {
+        return header.next == &header;
+    }
+    size_type size() const {
+        return hh_std::distance(begin(), end());
+    }
+    reference front() {
+        return *begin();
+    }
+    const_reference front() const {
+        return *begin();
+    }
+    reference back() {
+        return *(--end());
+    }
+    const_reference back() const {
+        return *(--end());
+    }
+    // The iterator of an element known to be in this list.
+    static iterator iterator_to(T &x) {
+        return iterator(hook_of(x));
+    }
+    static const_iterator iterator_to(const T &x) {
+        return const_iterator(iterator(hook_of(const_cast<T&>(x))));
+    }
+
+    iterator insert(iterator pos, T &x) {
+        assert(!static_cast<hook_type&>(x).is_linked() && "object is already in an intrusive_list");
+        link_before(pos.node, hook_of(x));
+        return iterator(hook_of(x));
+    }
+    void push_front(T &x) {
+        insert(begin(), x);
+    }
+    void push_back(T &x) {
+        insert(end(), x);
+    }
+    void pop_front() {
+        unlink_node(header.next);
+    }
+    void pop_back() {
+        unlink_node(header.prev);
+    }
+    iterator erase(iterator pos) {
+        __list_node_base *next = pos.node->next;
+        unlink_node(pos.node);
+        return iterator(next);
+    }
+    iterator erase(iterator first, iterator last) {
+        while(first != last) {
+            first = erase(first);
+        }
+        return last;
+    }
+    void remove(T &x) {
+        unlink_node(hook_of(x));
+    }
+    template <class Predicate>
+    void remove_if(Predicate pred) {
+        iterator first = begin();
+        while(first != end()) {
+            if(pred(*first)) {
+                first = erase(first);
+            } else {
+                ++first;
+            }
+        }
+    }
+    void clear() {
+        while(!empty()) {
+            pop_front();
+        }
+    }
+    void splice(iterator pos, intrusive_list &x) {
+        if(&x != this && !x.empty()) {
+            transfer(pos.node, x.header.next, &x.header);
+        }
+    }
+    void splice(iterator pos, intrusive_list&, iterator i) {
+        transfer(pos.node, i.node, i.node->next);
+    }
+    void splice(iterator pos, intrusive_list&, iterator first, iterator last) {
+        transfer(pos.node, first.node, last.node);
+    }
+    void reverse() {
+        __list_node_base *cur = &header;
+        do {
+            __list_node_base *tmp = cur->next;
+            cur->next = cur->prev;
+            cur->prev = tmp;
+            cur = tmp;
+        } while(cur != &header);
+    }
+    void swap(intrusive_list &x) {
+        intrusive_list tmp(std::move(x));
+        x.steal(*this);
+        steal(tmp);
+    }
+};
+
+template <class T, class Tag>
+inline void swap(intrusive_list<T, Tag> &x, intrusive_list<T, Tag> &y) {
+    x.swap(y);
+}
+
+};
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef __HH_STL_INTRUSIVE_SLIST_H_
+#define __HH_STL_INTRUSIVE_SLIST_H_
+
+#include<cstddef>
+#include<cassert>
+#include<utility>
+#include "hh_stl_iterator.h"
+#include "hh_stl_slist.h"
+
+namespace hh_std {
+
+// A singly linked list of objects that carry their own link, the intrusive
+// counterpart of slist.  T derives from intrusive_slist_hook<Tag>, which is a
+// __slist_node_base, so the slist link helpers work on it unchanged.  The
+// list never allocates, copies or destroys a T.
+//
+// The last element's next is null as in slist, so an unlinked hook points at
+// itself instead; is_linked() is exact, and linking a linked hook or
+// destroying one trips an assert.
+
+template <class Tag = void>
+class intrusive_slist_hook: public __slist_node_base {
+public:
+    intrusive_slist_hook() {
+        next = this;
+    }
+    // Copying an object does not copy its membership.
+    intrusive_slist_hook(const intrusive_slist_hook&) {
+        next = this;
+    }
+    intrusive_slist_hook &operator= (const intrusive_slist_hook&) {
+        return *this;
+    }
+    ~intrusive_slist_hook() {
+        assert(!is_linked() && "object destroyed while still in an intrusive_slist");
+    }
+    bool is_linked() const {
+        return next != this;
+    }
+};
+
+template <class T, class Tag, class Ref, class Ptr>
+struct __intrusive_slist_iterator: public __slist_iterator_base {
+    typedef T value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef __intrusive_slist_iterator<T, Tag, T&, T*> iterator;
+    typedef __intrusive_slist_iterator<T, Tag, const T&, const T*> const_iterator;
+    typedef __intrusive_slist_iterator self;
+    typedef intrusive_slist_hook<Tag> hook_type;
+
+    explicit __intrusive_slist_iterator(__slist_node_base *x): __slist_iterator_base(x) {}
+    __intrusive_slist_iterator(): __slist_iterator_base(0) {}
+    __intrusive_slist_iterator(const iterator &x): __slist_iterator_base(x.node) {}
+
+    reference operator* () const {
+        return *static_cast<T*>(static_cast<hook_type*>(node));
+    }
+    pointer operator-> () const {
+        return &(operator*());
+    }
+    self &operator++ () {
+        incr();
+        return *this;
+    }
+    self operator++ (int) {
+        self tmp = *this;
+        incr();
+        return tmp;
+    }
+};
+
+template <class T, class Tag = void>
+class intrusive_slist {
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef intrusive_slist_hook<Tag> hook_type;
+    typedef __intrusive_slist_iterator<T, Tag, T&, T*> iterator;
+    typedef __intrusive_slist_iterator<T, Tag, const T&, const T*> const_iterator;
+protected:
+    __slist_node_base head;
+
+    static __slist_node_base *hook_of(T &x) {
+        return static_cast<hook_type*>(&x);
+    }
+    static void unlink_after(__slist_node_base *prev) {
+        __slist_node_base *x = prev->next;
+        prev->next = x->next;
+        x->next = x;
+    }
+public:
+    intrusive_slist() {
+        head.next = 0;
+    }
+    intrusive_slist(const intrusive_slist&) = delete;
+    intrusive_slist &operator= (const intrusive_slist&) = delete;
+    intrusive_slist(intrusive_slist &&x) {
+        head.next = x.head.next;
+        x.head.next = 0;
+    }
+    intrusive_slist &operator= (intrusive_slist &&x) {
+        if(&x != this) {
+            clear();
+            head.next = x.head.next;
+            x.head.next = 0;
+        }
+        return *this;
+    }
+    // Unlinks the elements; they are not destroyed.
+    ~intrusive_slist() {
+        clear();
+    }
+
+    iterator before_begin() {
+        return iterator(&head);
+    }
+    const_iterator before_begin() const {
+        return const_iterator(iterator(const_cast<__slist_node_base*>(&head)));
+    }
+    iterator begin() {
+        return iterator(head.next);
+    }
+    const_iterator begin() const {
+        return const_iterator(iterator(head.next));
+    }
+    iterator end() {
+        return iterator(0);
+    }
+    const_iterator end() const {
+        return const_iterator(iterator(0));
+    }
+    bool empty() const {
+        return head.next == 0;
+    }
+    size_type size() const {
+        return __slist_size(head.next);
+    }
+    reference front() {
+        return *begin();
+    }
+    const_reference front() const {
+        return *begin();
+    }
+    // The iterator of an element known to be in this list.
+    static iterator iterator_to(T &x) {
+        return iterator(hook_of(x));
+    }
+    static const_iterator iterator_to(const T &x) {
+        return const_iterator(iterator(hook_of(const_cast<T&>(x))));
+    }
+    // O(n): walks from the head.
+    iterator previous(const_iterator pos) {
+        return iterator(__slist_previous(&head, pos.node));
+    }
+
+    iterator insert_after(const_iterator pos, T &x) {
+        assert(!static_cast<hook_type&>(x).is_linked() && "object is already in an intrusive_slist");
+        return iterator(__slist_make_link(pos.node, hook_of(x)));
+    }
+    // O(n), like slist::insert.
+    iterator insert(const_iterator pos, T &x) {
+        return insert_after(previous(pos), x);
+    }
+    void push_front(T &x) {
+        insert_after(before_begin(), x);
+    }
+    void pop_front() {
+        unlink_after(&head);
+    }
+    iterator erase_after(const_iterator pos) {
+        unlink_after(pos.node);
+        return iterator(pos.node->next);
+    }
+    iterator erase_after(const_iterator before_first, const_iterator last) {
+        while(before_first.node->next != last.node) {
+            unlink_after(before_first.node);
+        }
+        return iterator(last.node);
+    }
+    // O(n): finds the predecessor first.
+    iterator erase(const_iterator pos) {
+        return erase_after(previous(pos));
+    }
+    void remove(T &x) {
+        erase(iterator_to(x));
+    }
+    template <class Predicate>
+    void remove_if(Predicate pred) {
+        __slist_node_base *cur = &head;
+        while(cur->next) {
+            if(pred(*iterator(cur->next))) {
+                unlink_after(cur);
+            } else {
+                cur = cur->next;
+            }
+        }
+    }
+    void clear() {
+        while(!empty()) {
+            pop_front();
+        }
+    }
+    // Moves (before_first, before_last] of the other list after pos.
+    void splice_after(const_iterator pos, intrusive_slist&, const_iterator before_first, const_iterator before_last) {
+        if(before_first != before_last) {
+            __slist_splice_after(pos.node, before_first.node, before_last.node);
+        }
+    }
+    // Moves all of x after pos.
+    void splice_after(const_iterator pos, intrusive_slist &x) {
+        if(&x != this && !x.empty()) {
+            __slist_splice_after(pos.node, &x.head, __slist_previous(&x.head, 0));
+        }
+    }
+    void reverse() {
+        head.next = __slist_reverse(head.next);
+    }
+    void swap(intrusive_slist &x) {
+        std::swap(head.next, x.head.next);
+    }
+};
+
+template <class T, class Tag>
+inline void swap(intrusive_slist<T, Tag> &x, intrusive_slist<T, Tag> &y) {
+    x.swap(y);
+}
+
+};
+
+#endif
@@ -48,6 +48,29 @@ struct iterator_traits<const T*> {
     typedef const T& reference;
 };
 
+// Segmented iterators: the range is made of several contiguous segments (such
+// as deque's buffers).  Once this template is specialized with category set to
+// __segmented_tag, copy/fill/for_each/find/accumulate process each segment's
+// [begin(s), end(s)) as a local_iterator (raw pointer) range, with no segment
+// boundary check per step.  A specialization provides:
+//   segment_iterator / local_iterator
+//   segment(it), local(it): split it into its segment and the position in it
+//   begin(s), end(s): the extent of a segment
+//   compose(s, l): rebuild the iterator; l == end(s) lands on the next segment
+struct __segmented_tag {};
+struct __non_segmented_tag {};
+
+template <class Iterator>
+struct __segmented_iterator_traits {
+    typedef __non_segmented_tag category;
+};
+
+template <class Iterator>
+inline typename __segmented_iterator_traits<Iterator>::category __segmented_category(const Iterator&) {
+    typedef typename __segmented_iterator_traits<Iterator>::category category;
+    return category();
+}
+
 template <class Iterator>
 inline typename iterator_traits<Iterator>::iterator_category category_type(const Iterator&) {
     typedef typename iterator_traits<Iterator>::iterator_category category;
@@ -120,7 +143,7 @@ inline void advance(InputIterator &first, Distance distance) {
 
 template <class BidirIterator>
 BidirIterator prev(BidirIterator it, typename iterator_traits<BidirIterator>::difference_type n = 1) {
-    advance(it, -n);
+    hh_std::advance(it, -n);
     return it;
 }
 
@@ -189,8 +212,8 @@ public:
         return current;
     }
 
-    reference &operator* () const {
-        return *prev(current);
+    reference operator* () const {
+        return *hh_std::prev(current);
     }
 
     pointer operator-> () const {
@@ -241,7 +264,7 @@ public:
         return *this;
     }
 
-    value_type &operator[] (size_t n) const {
+    reference operator[] (size_t n) const {
         return *(*this + n);
     }
 
@@ -2,6 +2,7 @@
 #define __HH_STL_LIST_H_
 
 #include<cstddef>
+#include<utility>
 #include "hh_stl_iterator.h"
 #include "hh_stl_alloc.h"
 #include "hh_stl_construct.h"
@@ -77,9 +78,10 @@ struct __list_iterator {
 };
 
 template <class T, class Alloc = alloc>
-class list {
+class list: private __alloc_holder<Alloc> {
 protected:
     typedef __list_node<T> list_node;
+    typedef __alloc_holder<Alloc> alloc_base;
     typedef simple_alloc<__list_node<T>, Alloc> data_allocater;
 public:
     typedef T value_type;
@@ -90,6 +92,7 @@ public:
     typedef list_node* link_type;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 
     typedef __list_iterator<T, T&, T*> iterator;
     typedef __list_iterator<T, const T&, const T*> const_iterator;
@@ -100,21 +103,27 @@ public:
 protected:
     link_type node;
     link_type get_node() {
-        return (link_type)data_allocater::allocate();
+        return (link_type)data_allocater::allocate(this->get_alloc());
     }
 
     void put_node(link_type p) {
-        data_allocater::deallocate(p, size_type(1));
+        data_allocater::deallocate(this->get_alloc(), p, size_type(1));
     }
 
-    link_type create_node(const T &x) {
+    template <class... Args>
+    link_type create_node(Args&&... args) {
         link_type node = get_node();
-        construct(&node->data, x);
+        try {
+            construct(&node->data, std::forward<Args>(args)...);
+        } catch(...) {
+            put_node(node);
+            throw;
+        }
         return node;
     }
 
     void destory_node(link_type p) {
-        destory(p);
+        destory(&p->data);
         put_node(p);
     }
 
@@ -124,12 +133,45 @@ protected:
         node->prev = node;
     }
 
+    void copy_assign_alloc(const list<T, Alloc> &x, __true_type) {
+        clear();
+        put_node(node);
+        this->get_alloc() = x.get_alloc();
+        empty_initialize();
+    }
+
+    void copy_assign_alloc(const list<T, Alloc> &, __false_type) {
+    }
+
+    // x keeps a valid (empty) state by taking over our old header, which
+    // belongs to our allocator, so the allocators are exchanged as well.
+    void move_assign(list<T, Alloc> &x, __true_type) {
+        clear();
+        std::swap(node, x.node);
+        __alloc_swap(this->get_alloc(), x.get_alloc(), __true_type());
+    }
+
+    void move_assign(list<T, Alloc> &x, __false_type) {
+        clear();
+        for(iterator cur = x.begin(); cur != x.end(); ++cur) {
+            push_back(std::move(*cur));
+        }
+        x.clear();
+    }
 
 public:
     list() {
         empty_initialize();
     }
 
+    explicit list(const allocator_type &a): alloc_base(a) {
+        empty_initialize();
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+
     iterator begin() {
         return iterator(node->next);
     }
@@ -167,7 +209,7 @@ public:
     }
 
     size_type size() const {
-        size_type n = distance(begin(), end());
+        size_type n = hh_std::distance(begin(), end());
         return n;
     }
 
@@ -192,6 +234,8 @@ public:
     }
 
     void swap(list<T, Alloc> &x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
         std::swap(node, x.node);
     }
 
@@ -207,7 +251,16 @@ public:
     }
 
     iterator insert(iterator pos, const T &x) {
-        link_type tmp = create_node(x);
+        return emplace(pos, x);
+    }
+
+    iterator insert(iterator pos, T &&x) {
+        return emplace(pos, std::move(x));
+    }
+
+    template <class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
+        link_type tmp = create_node(std::forward<Args>(args)...);
         tmp->next = pos.node;
         tmp->prev = (pos.node)->prev;
         tmp->prev->next = tmp;
@@ -236,16 +289,34 @@ public:
         insert(end(), x);
     }
 
+    void push_back(T &&x) {
+        insert(end(), std::move(x));
+    }
+
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        emplace(end(), std::forward<Args>(args)...);
+    }
+
     void push_front(const T &x) {
         insert(begin(), x);
     }
 
+    void push_front(T &&x) {
+        insert(begin(), std::move(x));
+    }
+
+    template <class... Args>
+    void emplace_front(Args&&... args) {
+        emplace(begin(), std::forward<Args>(args)...);
+    }
+
     iterator erase(iterator pos) {
         link_type tmp = pos.node;
         tmp->prev->next = tmp->next;
         tmp->next->prev = tmp->prev;
         link_type result = tmp->next;
-        put_node(tmp);
+        destory_node(tmp);
         return iterator(result);
     }
 
@@ -265,27 +336,34 @@ public:
         erase(--end());
     }
 
-    list(size_type n, const T &x) {
+    list(size_type n, const T &x, const allocator_type &a = allocator_type()): alloc_base(a) {
         fill_initialize(n, x);
     }
-    list(int n, const T &x) {
+    list(int n, const T &x, const allocator_type &a = allocator_type()): alloc_base(a) {
         fill_initialize(n, x);
     }
-    list(long n, const T &x) {
+    list(long n, const T &x, const allocator_type &a = allocator_type()): alloc_base(a) {
         fill_initialize(n, x);
     }
     explicit list(size_type n) {
         fill_initialize(n, T());
     }
     template <class InputIterator>
-    list(InputIterator first, InputIterator last) {
+    list(InputIterator first, InputIterator last, const allocator_type &a = allocator_type()):
+        alloc_base(a) {
         range_initialize(first, last);
     }
 
-    list(const list<T, Alloc> &x) {
+    list(const list<T, Alloc> &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())) {
         range_initialize(x.begin(), x.end());
     }
 
+    list(list<T, Alloc> &&x): alloc_base(x.get_alloc()) {
+        empty_initialize();
+        std::swap(node, x.node);
+    }
+
     ~list() {
         clear();
         put_node(node);
@@ -293,6 +371,13 @@ public:
 
     list<T, Alloc> &operator= (const list<T, Alloc> &x);
 
+    list<T, Alloc> &operator= (list<T, Alloc> &&x) {
+        if(this != &x) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+
     void play_all() {
         iterator cur = begin();
         while(cur != end()) {
@@ -318,7 +403,7 @@ protected:
 
 public:
     void splice(iterator pos, list<T, Alloc> &x) {
-        if(x != *this && !x.empty()) {
+        if(&x != this && !x.empty()) {
             transfer(pos, x.begin(), x.end());
         }
     }
@@ -344,13 +429,29 @@ public:
     template <class StrictWeakOrdering> void merge(list&, StrictWeakOrdering);
     template <class StrictWeakOrdering> void sort(StrictWeakOrdering);
 
+protected:
+    typedef simple_alloc<link_type, Alloc> link_allocater;
+    static link_type __append_chain(link_type a, link_type b);
+    template <class StrictWeakOrdering>
+    static void __merge_chain(link_type &a, link_type b, StrictWeakOrdering order);
+    void __relink_chains(link_type *chains, size_type n, link_type rest);
+    template <class StrictWeakOrdering>
+    void __sort_chain(StrictWeakOrdering order);
+    template <class StrictWeakOrdering>
+    void __sort_buffered(StrictWeakOrdering order, size_type n);
+    template <class StrictWeakOrdering>
+    void __sort(StrictWeakOrdering order, __true_type);
+    template <class StrictWeakOrdering>
+    void __sort(StrictWeakOrdering order, __false_type);
+public:
+
     template <class T1, class Alloc1>
     friend bool operator== (const list<T1, Alloc1> &x, const list<T1, Alloc1> &y);
 };
 
 template <class T, class Alloc>
 inline bool operator== (const list<T, Alloc> &x, const list<T, Alloc> &x1) {
-    typedef typename list<T, Alloc>::iterator iterator;
+    typedef typename list<T, Alloc>::const_iterator iterator;
     iterator first_x = x.begin(), last_x = x.end();
     iterator first_x1 = x1.begin(), last_x1 = x1.end();
     while(first_x != last_x && first_x1 != last_x1) {
@@ -368,7 +469,7 @@ inline bool operator== (const list<T, Alloc> &x, const list<T, Alloc> &x1) {
 
 template <class T, class Alloc>
 inline bool operator<(const list<T, Alloc>& x, const list<T, Alloc>& x1) {
-    typedef typename list<T, Alloc>::iterator iterator;
+    typedef typename list<T, Alloc>::const_iterator iterator;
     iterator first_x = x.begin(), last_x = x.end();
     iterator first_x1 = x1.begin(), last_x1 = x1.end();
     while(first_x != last_x && first_x1 != last_x1) {
@@ -391,9 +492,10 @@ inline void swap(list<T, Alloc>& x, list<T, Alloc>& y) {
 
 template <class T, class Alloc>
 inline list<T, Alloc> &list<T, Alloc>::operator= (const list<T, Alloc> &x) {
-    if(*this != x) {
+    if(this != &x) {
+        copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
         iterator first = begin(), last = end();
-        iterator first_x = x.begin(), last_x = x.end();
+        const_iterator first_x = x.begin(), last_x = x.end();
         while(first != last && first_x != last_x) {
             *first = *first_x;
             ++first;
@@ -405,8 +507,8 @@ inline list<T, Alloc> &list<T, Alloc>::operator= (const list<T, Alloc> &x) {
         if(first_x != last_x) {
             insert(last, first_x, last_x);
         }
-        return *this;
     }
+    return *this;
 }
 
 template <class T, class Alloc>
@@ -545,27 +647,215 @@ inline void list<T, Alloc>::reverse() {
     }
 }
 
+// Null-terminated chain a followed by chain b.
+template <class T, class Alloc>
+inline typename list<T, Alloc>::link_type list<T, Alloc>::__append_chain(link_type a, link_type b) {
+    if(a == 0) {
+        return b;
+    }
+    link_type last = a;
+    while(last->next) {
+        last = last->next;
+    }
+    last->next = b;
+    return a;
+}
+
+// Merges chain b into chain a.  a holds the earlier elements; b wins only
+// when it strictly precedes.  If order throws, a still ends up holding every
+// node of both chains, unsorted, so the caller can put the list back together.
 template <class T, class Alloc>
 template <class StrictWeakOrdering>
-inline void list<T, Alloc>::sort(StrictWeakOrdering order) {
-    if(size() > 1) {
-        list<T, Alloc> avail, counts[64];
-        size_type fill = 0;
-        while(!empty()) {
-            avail.splice(avail.begin(), *this, begin());
+inline void list<T, Alloc>::__merge_chain(link_type &a, link_type b, StrictWeakOrdering order) {
+    link_type result = 0;
+    link_type *tail = &result;
+    __STL_TRY {
+        while(a && b) {
+            if(order(a->data, b->data)) {
+                *tail = b;
+                b = b->next;
+            } else {
+                *tail = a;
+                a = a->next;
+            }
+            tail = &(*tail)->next;
+        }
+    }
+    __STL_UNWIND((*tail = __append_chain(a, b), a = result));
+    *tail = a ? a : b;
+    a = result;
+}
+
+// Links the chains, then rest, back into the ring in that order.
+template <class T, class Alloc>
+inline void list<T, Alloc>::__relink_chains(link_type *chains, size_type n, link_type rest) {
+    link_type prev = node;
+    for(size_type i = 0; i <= n; i++) {
+        for(link_type cur = i < n ? chains[i] : rest; cur; cur = cur->next) {
+            prev->next = cur;
+            cur->prev = prev;
+            prev = cur;
+        }
+    }
+    prev->next = node;
+    node->prev = prev;
+}
+
+// Bottom-up merge sort over the nodes' next links; no temporary lists are
+// built, so sorting never goes through the allocator.  Every node is always
+// in exactly one of counts[] or the unsorted rest cur, so a throwing order
+// relinks those into a valid list in some permutation before rethrowing.
+template <class T, class Alloc>
+template <class StrictWeakOrdering>
+inline void list<T, Alloc>::__sort_chain(StrictWeakOrdering order) {
+    if(node->next == node || node->next->next == node) return;
+    link_type counts[64];
+    size_type fill = 0;
+    link_type cur = node->next;
+    node->prev->next = 0;
+    __STL_TRY {
+        while(cur) {
+            link_type carry = cur;
+            cur = cur->next;
+            carry->next = 0;
             size_type i = 0;
-            while(i < fill && !counts[i].empty()) {
-                counts[i].merge(avail, order);
-                avail.swap(counts[i]);
+            while(i < fill && counts[i]) {
+                __merge_chain(counts[i], carry, order);
+                carry = counts[i];
+                counts[i] = 0;
                 i++;
             }
-            avail.swap(counts[i]);
+            counts[i] = carry;
             if(i == fill) fill++;
         }
-        for(size_type i = 0; i < fill; i++) {
-            merge(counts[i], order);
+        for(size_type i = 1; i < fill; i++) {
+            link_type later = counts[i - 1];
+            counts[i - 1] = 0;
+            if(counts[i]) {
+                __merge_chain(counts[i], later, order);
+            } else {
+                counts[i] = later;
+            }
         }
     }
+    __STL_UNWIND(__relink_chains(counts, fill, cur));
+    __relink_chains(counts + fill - 1, 1, 0);
+}
+
+inline void __list_prefetch(const void *p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// In a long list the nodes are scattered over the heap, and merging by chasing
+// next pointers misses the cache at every step.  This collects the node
+// pointers into a contiguous array, runs a stable bottom-up merge on it while
+// prefetching the nodes a few steps ahead, then relinks the nodes in order.
+// Only pointers move, never elements; the array takes 2n pointers.
+template <class T, class Alloc>
+template <class StrictWeakOrdering>
+inline void list<T, Alloc>::__sort_buffered(StrictWeakOrdering order, size_type n) {
+    enum { run = 16, ahead = 8 };
+    link_type *buf = link_allocater::allocate(this->get_alloc(), 2 * n);
+    link_type *a = buf, *b = buf + n;
+    link_type cur = node->next;
+    for(size_type i = 0; i < n; i++, cur = cur->next) {
+        a[i] = cur;
+    }
+    // The comparator may throw; the links are not touched until the final
+    // pass, so the list is still intact and only the array has to go.
+    __STL_TRY {
+        // Insertion-sort runs of length run first; an element only moves left when
+        // it strictly goes first, which keeps the sort stable.
+        for(size_type lo = 0; lo < n; lo += run) {
+            size_type hi = lo + run < n ? lo + run : n;
+            for(size_type i = lo + 1; i < hi; i++) {
+                link_type x = a[i];
+                size_type j = i;
+                while(j > lo && order(a[j - 1]->data, x->data)) {
+                    a[j] = a[j - 1];
+                    --j;
+                }
+                a[j] = x;
+            }
+        }
+        for(size_type width = run; width < n; width *= 2) {
+            for(size_type lo = 0; lo < n; lo += 2 * width) {
+                size_type mid = lo + width < n ? lo + width : n;
+                size_type hi = lo + 2 * width < n ? lo + 2 * width : n;
+                size_type i = lo, j = mid, k = lo;
+                while(i < mid && j < hi) {
+                    if(i + ahead < mid) {
+                        __list_prefetch(&a[i + ahead]->data);
+                    }
+                    if(j + ahead < hi) {
+                        __list_prefetch(&a[j + ahead]->data);
+                    }
+                    if(order(a[i]->data, a[j]->data)) {
+                        b[k++] = a[j++];
+                    } else {
+                        b[k++] = a[i++];
+                    }
+                }
+                while(i < mid) {
+                    b[k++] = a[i++];
+                }
+                while(j < hi) {
+                    b[k++] = a[j++];
+                }
+            }
+            link_type *tmp = a;
+            a = b;
+            b = tmp;
+        }
+    }
+    __STL_UNWIND(link_allocater::deallocate(this->get_alloc(), buf, 2 * n));
+    link_type prev = node;
+    for(size_type i = 0; i < n; i++) {
+        prev->next = a[i];
+        a[i]->prev = prev;
+        prev = a[i];
+    }
+    prev->next = node;
+    node->prev = prev;
+    link_allocater::deallocate(this->get_alloc(), buf, 2 * n);
+}
+
+// From this length on sort uses __sort_buffered.  Shorter lists mostly sit in
+// cache, where the in-place merge is cheaper and needs no scratch space.
+enum { __list_sort_buffer_threshold = 65536 };
+
+// Only POD elements take __sort_buffered: their comparison reads just the node,
+// so the prefetch pays off.  For types like string the comparison chases
+// another pointer and the array merge ends up slower.
+template <class T, class Alloc>
+template <class StrictWeakOrdering>
+inline void list<T, Alloc>::__sort(StrictWeakOrdering order, __true_type) {
+    size_type n = 0;
+    for(link_type cur = node->next; cur != node; cur = cur->next) {
+        n++;
+    }
+    if(n >= size_type(__list_sort_buffer_threshold)) {
+        __sort_buffered(order, n);
+    } else {
+        __sort_chain(order);
+    }
+}
+
+template <class T, class Alloc>
+template <class StrictWeakOrdering>
+inline void list<T, Alloc>::__sort(StrictWeakOrdering order, __false_type) {
+    __sort_chain(order);
+}
+
+template <class T, class Alloc>
+template <class StrictWeakOrdering>
+inline void list<T, Alloc>::sort(StrictWeakOrdering order) {
+    if(node->next == node || node->next->next == node) return;
+    __sort(order, typename __type_traits<T>::is_POD_type());
 }
 
 template <class T, class Alloc>
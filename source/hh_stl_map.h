@@ -52,6 +52,7 @@ public:
     typedef typename rep_type::const_r_iterator const_r_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::allocator_type allocator_type;
 
     map(): t(Compare()) {}
     explicit map(Compare &c): t(c) {}
@@ -63,11 +64,20 @@ public:
     map(InputIterator first, InputIterator last, Compare &c): t(c) {
         t.insert_unique(first, last);
     }
+    map(const Compare &c, const allocator_type &a): t(c, a) {}
     map(const map<Key, T, Compare, Alloc> &x): t(x.t) {}
     map<Key, T, Compare, Alloc> &operator= (const map<Key, T, Compare, Alloc> &x) {
         t = x.t;
         return *this;
     }
+    map(map<Key, T, Compare, Alloc> &&x): t(std::move(x.t)) {}
+    map<Key, T, Compare, Alloc> &operator= (map<Key, T, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
+    allocator_type get_allocator() const {
+        return t.get_allocator();
+    }
     key_compare key_comp() const {
         return t.key_comp();
     }
@@ -110,7 +120,10 @@ public:
     T &operator[] (const key_type &k) {
         return (*(insert(value_type(k, T())).first)).second;
     }
-    void swap(const map<Key, T, Compare, Alloc> &x) {
+    T &operator[] (key_type &&k) {
+        return (*(insert(value_type(std::move(k), T())).first)).second;
+    }
+    void swap(map<Key, T, Compare, Alloc> &x) {
         t.swap(x.t);
     }
     hh_std::pair<iterator, bool> insert(const value_type &x) {
@@ -119,6 +132,20 @@ public:
     iterator insert(iterator pos, const value_type &x) {
         return t.insert_unique(pos, x);
     }
+    hh_std::pair<iterator, bool> insert(value_type &&x) {
+        return t.insert_unique(std::move(x));
+    }
+    iterator insert(iterator pos, value_type &&x) {
+        return t.insert_unique(pos, std::move(x));
+    }
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace(Args&&... args) {
+        return t.emplace_unique(std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    iterator emplace_hint(iterator pos, Args&&... args) {
+        return t.emplace_hint_unique(pos, std::forward<Args>(args)...);
+    }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
         t.insert_unique(first, last);
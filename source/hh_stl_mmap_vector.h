@@ -0,0 +1,367 @@
+#ifndef __HH_STL_MMAP_VECTOR_H_
+#define __HH_STL_MMAP_VECTOR_H_
+
+#include<cstddef>
+#include<cstring>
+#include<utility>
+#include<type_traits>
+#include<system_error>
+#include<cerrno>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include "hh_stl_iterator.h"
+
+namespace hh_std {
+
+// A vector whose elements live in a file mapped with MAP_SHARED.  Opening an
+// existing file maps it as is, so nothing is read until a page is touched.
+// Iterators are plain pointers into the mapping, as in vector.
+//
+// The file is kept ftruncate'd to capacity() while open, and close() trims it
+// back to size().  A process that dies without closing leaves zeroed slack at
+// the end of the file, and the next open() counts those zeroed records as elements.
+// Growth remaps the file, which invalidates iterators just like vector does.
+// A failed ftruncate or mmap during growth throws std::system_error carrying
+// errno and leaves the elements as they were.  A read_only mapping is
+// PROT_READ: writing through it faults, and growing it throws EBADF.
+template <class T>
+class mmap_vector {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "mmap_vector stores raw bytes in a file and needs a trivially copyable T");
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type* iterator;
+    typedef const value_type* const_iterator;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef reverse_iterator<const_iterator>  const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+
+    enum open_mode { read_only, read_write, truncate };
+protected:
+    int fd;
+    bool writable;
+    iterator start;
+    iterator finish;
+    iterator end_of_storage;
+
+    void reset() {
+        fd = -1;
+        writable = false;
+        start = finish = end_of_storage = 0;
+    }
+    static iterator map_file(int file, size_type n, bool rw) {
+        if(n == 0) {
+            return 0;
+        }
+        void *p = ::mmap(0, n * sizeof(T), rw ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+        return p == MAP_FAILED ? 0 : static_cast<iterator>(p);
+    }
+    static void throw_error(int err, const char *what) {
+        throw std::system_error(err, std::generic_category(), what);
+    }
+    void unmap() {
+        if(start) {
+            ::munmap(start, capacity() * sizeof(T));
+        }
+    }
+    // Resizes the file to new_capacity elements and maps the result.
+    // Elements past new_capacity are lost, so callers never shrink below size().
+    void remap(size_type new_capacity) {
+        if(!writable) {
+            throw_error(EBADF, "mmap_vector: growing a read-only mapping");
+        }
+        if(::ftruncate(fd, new_capacity * sizeof(T)) != 0) {
+            throw_error(errno, "mmap_vector: ftruncate");
+        }
+        size_type old_size = size();
+        iterator new_start;
+#ifdef MREMAP_MAYMOVE
+        if(start != 0 && new_capacity != 0) {
+            // On failure the old mapping is still intact.
+            void *p = ::mremap(start, capacity() * sizeof(T), new_capacity * sizeof(T), MREMAP_MAYMOVE);
+            if(p == MAP_FAILED) {
+                throw_error(errno, "mmap_vector: mremap");
+            }
+            new_start = static_cast<iterator>(p);
+        } else
+#endif
+        {
+            unmap();
+            new_start = map_file(fd, new_capacity, true);
+            if(new_start == 0 && new_capacity != 0) {
+                int err = errno;
+                // The file still covers the old elements, so the old view can
+                // usually be mapped again.  If even that fails, drop the view
+                // and the write access so close() cannot truncate the data.
+                size_type old_capacity = capacity();
+                start = map_file(fd, old_capacity, true);
+                finish = start + old_size;
+                end_of_storage = start + old_capacity;
+                if(start == 0) {
+                    finish = end_of_storage = 0;
+                    writable = false;
+                }
+                throw_error(err, "mmap_vector: mmap");
+            }
+        }
+        start = new_start;
+        finish = start + old_size;
+        end_of_storage = start + new_capacity;
+    }
+    // Doubles like vector, but never grows by less than a page of elements,
+    // since every growth is a syscall pair.
+    size_type next_capacity(size_type n) const {
+        size_type len = capacity() == 0 ? 1 : 2 * capacity();
+        size_type page = size_type(::sysconf(_SC_PAGESIZE)) / sizeof(T);
+        if(len < page) {
+            len = page;
+        }
+        return len < n ? n : len;
+    }
+    void grow_for(size_type n) {
+        if(n > capacity()) {
+            remap(next_capacity(n));
+        }
+    }
+public:
+    mmap_vector() {
+        reset();
+    }
+    explicit mmap_vector(const char *path, open_mode mode = read_write) {
+        reset();
+        open(path, mode);
+    }
+    mmap_vector(const mmap_vector&) = delete;
+    mmap_vector& operator=(const mmap_vector&) = delete;
+    mmap_vector(mmap_vector &&x):
+        fd(x.fd), writable(x.writable),
+        start(x.start), finish(x.finish), end_of_storage(x.end_of_storage) {
+        x.reset();
+    }
+    mmap_vector& operator=(mmap_vector &&x) {
+        if(&x != this) {
+            close();
+            swap(x);
+        }
+        return *this;
+    }
+    ~mmap_vector() {
+        close();
+    }
+
+    // Maps the whole file.  Returns false and leaves *this closed if the
+    // file cannot be opened or mapped.  A trailing partial record is ignored
+    // by a read_only open; a writable open refuses the file with EINVAL,
+    // since trimming it to capacity() would cut the partial record off.
+    bool open(const char *path, open_mode mode = read_write) {
+        close();
+        int flags = mode == read_only ? O_RDONLY : (O_RDWR | O_CREAT);
+        if(mode == truncate) {
+            flags |= O_TRUNC;
+        }
+        int file = ::open(path, flags, 0644);
+        if(file < 0) {
+            return false;
+        }
+        struct stat st;
+        if(::fstat(file, &st) != 0) {
+            ::close(file);
+            return false;
+        }
+        if(mode != read_only && size_type(st.st_size) % sizeof(T) != 0) {
+            ::close(file);
+            errno = EINVAL;
+            return false;
+        }
+        size_type n = size_type(st.st_size) / sizeof(T);
+        iterator p = map_file(file, n, mode != read_only);
+        if(n != 0 && p == 0) {
+            ::close(file);
+            return false;
+        }
+        fd = file;
+        writable = mode != read_only;
+        start = finish = p;
+        finish += n;
+        end_of_storage = finish;
+        return true;
+    }
+    // Trims the file to size(), unmaps it and closes the descriptor.
+    void close() {
+        if(fd < 0) {
+            return;
+        }
+        size_type n = size();
+        unmap();
+        if(writable && ::ftruncate(fd, n * sizeof(T)) != 0) {
+            // Nothing sensible to do in a destructor; the slack stays zeroed.
+        }
+        ::close(fd);
+        reset();
+    }
+    // Flushes dirty pages to the file.  async only schedules the write.
+    bool sync(bool async = false) {
+        return start == 0 || ::msync(start, capacity() * sizeof(T), async ? MS_ASYNC : MS_SYNC) == 0;
+    }
+    bool is_open() const {
+        return fd >= 0;
+    }
+    bool is_writable() const {
+        return writable;
+    }
+
+    iterator begin() {
+        return start;
+    }
+    const_iterator begin() const {
+        return start;
+    }
+    iterator end() {
+        return finish;
+    }
+    const_iterator end() const {
+        return finish;
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    pointer data() {
+        return start;
+    }
+    const_pointer data() const {
+        return start;
+    }
+    size_type size() const {
+        return finish - start;
+    }
+    size_type max_size() const {
+        return size_type(-1) / sizeof(T);
+    }
+    size_type capacity() const {
+        return end_of_storage - start;
+    }
+    bool empty() const {
+        return finish == start;
+    }
+    reference operator[](size_type n) {
+        return *(start + n);
+    }
+    const_reference operator[](size_type n) const {
+        return *(start + n);
+    }
+    reference front() {
+        return *start;
+    }
+    const_reference front() const {
+        return *start;
+    }
+    reference back() {
+        return *(finish - 1);
+    }
+    const_reference back() const {
+        return *(finish - 1);
+    }
+
+    void reserve(size_type n) {
+        if(n > capacity()) {
+            remap(n);
+        }
+    }
+    void push_back(const T &x) {
+        if(finish == end_of_storage) {
+            T x_copy = x;  // x may live in the mapping that remap moves
+            grow_for(size() + 1);
+            *finish++ = x_copy;
+        } else {
+            *finish++ = x;
+        }
+    }
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        T x(std::forward<Args>(args)...);
+        grow_for(size() + 1);
+        *finish++ = x;
+    }
+    void pop_back() {
+        --finish;
+    }
+    iterator insert(iterator pos, const T &x) {
+        size_type index = pos - start;
+        T x_copy = x;
+        grow_for(size() + 1);
+        pos = start + index;
+        std::memmove(pos + 1, pos, (finish - pos) * sizeof(T));
+        *pos = x_copy;
+        ++finish;
+        return pos;
+    }
+    template <class InputIterator>
+    void append(InputIterator first, InputIterator last) {
+        for(; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+    iterator erase(iterator pos) {
+        return erase(pos, pos + 1);
+    }
+    iterator erase(iterator first, iterator last) {
+        std::memmove(first, last, (finish - last) * sizeof(T));
+        finish -= last - first;
+        return first;
+    }
+    // New elements are value-initialized; the file pages behind them are
+    // already zero, but T() need not be.
+    void resize(size_type new_size, const T &x = T()) {
+        if(new_size < size()) {
+            finish = start + new_size;
+        } else {
+            T x_copy = x;
+            grow_for(new_size);
+            while(finish != start + new_size) {
+                *finish++ = x_copy;
+            }
+        }
+    }
+    void clear() {
+        finish = start;
+    }
+    // Gives the slack back to the file system.
+    void shrink_to_fit() {
+        if(writable && capacity() != size()) {
+            remap(size());
+        }
+    }
+    void swap(mmap_vector &x) {
+        std::swap(fd, x.fd);
+        std::swap(writable, x.writable);
+        std::swap(start, x.start);
+        std::swap(finish, x.finish);
+        std::swap(end_of_storage, x.end_of_storage);
+    }
+};
+
+template <class T>
+inline void swap(mmap_vector<T> &a, mmap_vector<T> &b) {
+    a.swap(b);
+}
+
+};
+
+#endif
@@ -52,6 +52,7 @@ public:
     typedef typename rep_type::const_r_iterator const_r_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::allocator_type allocator_type;
 
     multimap(): t(Compare()) {}
     explicit multimap(Compare &c): t(c) {}
@@ -63,11 +64,20 @@ public:
     multimap(InputIterator first, InputIterator last, Compare &c): t(c) {
         t.insert_equal(first, last);
     }
+    multimap(const Compare &c, const allocator_type &a): t(c, a) {}
     multimap(const multimap<Key, T, Compare, Alloc> &x): t(x.t) {}
     multimap<Key, T, Compare, Alloc> &operator= (const multimap<Key, T, Compare, Alloc> &x) {
         t = x.t;
         return *this;
     }
+    multimap(multimap<Key, T, Compare, Alloc> &&x): t(std::move(x.t)) {}
+    multimap<Key, T, Compare, Alloc> &operator= (multimap<Key, T, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
+    allocator_type get_allocator() const {
+        return t.get_allocator();
+    }
     key_compare key_comp() const {
         return t.key_comp();
     }
@@ -107,7 +117,7 @@ public:
     size_type max_size() const {
         return t.max_size();
     }
-    void swap(const multimap<Key, T, Compare, Alloc> &x) {
+    void swap(multimap<Key, T, Compare, Alloc> &x) {
         t.swap(x.t);
     }
     iterator insert(const value_type &x) {
@@ -116,6 +126,20 @@ public:
     iterator insert(iterator pos, const value_type &x) {
         return t.insert_equal(pos, x);
     }
+    iterator insert(value_type &&x) {
+        return t.insert_equal(std::move(x));
+    }
+    iterator insert(iterator pos, value_type &&x) {
+        return t.insert_equal(pos, std::move(x));
+    }
+    template <class... Args>
+    iterator emplace(Args&&... args) {
+        return t.emplace_equal(std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    iterator emplace_hint(iterator pos, Args&&... args) {
+        return t.emplace_hint_equal(pos, std::forward<Args>(args)...);
+    }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
         t.insert_equal(first, last);
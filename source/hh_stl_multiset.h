@@ -41,6 +41,7 @@ public:
     typedef typename rep_type::const_iterator const_iterator;
     typedef typename rep_type::const_r_iterator r_iterator;
     typedef typename rep_type::const_r_iterator const_r_iterator;
+    typedef typename rep_type::allocator_type allocator_type;
     multiset(): t(Compare()) {}
     explicit multiset(const Compare &comp): t(comp) {}
     template <class InputIterator>
@@ -51,11 +52,20 @@ public:
     multiset(InputIterator first, InputIterator last, const Compare &comp): t(comp) {
         t.insert_equal(first, last);
     }
+    multiset(const Compare &c, const allocator_type &a): t(c, a) {}
     multiset(const multiset<Key, Compare, Alloc> &x): t(x.t) {}
     multiset<Key, Compare, Alloc> &operator= (const multiset<Key, Compare, Alloc> &x) {
         t = x.t;
         return *this;
     }
+    multiset(multiset<Key, Compare, Alloc> &&x): t(std::move(x.t)) {}
+    multiset<Key, Compare, Alloc> &operator= (multiset<Key, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
+    allocator_type get_allocator() const {
+        return t.get_allocator();
+    }
     key_compare key_comp() const {
         return t.comp;
     }
@@ -90,8 +100,23 @@ public:
         typename rep_type::iterator result = t.insert_equal(x);
         return iterator(result.node);
     }
+    iterator insert(value_type &&x) {
+        typename rep_type::iterator result = t.insert_equal(std::move(x));
+        return iterator(result.node);
+    }
     iterator insert(iterator pos, const value_type &x) {
-        return t.insert((typename rep_type::iterator)pos, x);
+        return iterator(t.insert_equal(typename rep_type::iterator(pos.node), x).node);
+    }
+    iterator insert(iterator pos, value_type &&x) {
+        return iterator(t.insert_equal(typename rep_type::iterator(pos.node), std::move(x)).node);
+    }
+    template <class... Args>
+    iterator emplace(Args&&... args) {
+        return iterator(t.emplace_equal(std::forward<Args>(args)...).node);
+    }
+    template <class... Args>
+    iterator emplace_hint(iterator pos, Args&&... args) {
+        return iterator(t.emplace_hint_equal(typename rep_type::iterator(pos.node), std::forward<Args>(args)...).node);
     }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
@@ -61,21 +61,62 @@ struct negate: public unary_function<T, T> {
 };
 
 template <class InputIterator, class T>
-T accumulate(InputIterator first, InputIterator last, T begin) {
+T __accumulate(InputIterator first, InputIterator last, T begin, __non_segmented_tag) {
     for(; first != last; ++first) {
         begin = begin + *first;
     }
     return begin;
 }
 
+// Accumulates segment by segment, each one a raw pointer range.
+template <class SegIter, class T>
+T __accumulate(SegIter first, SegIter last, T begin, __segmented_tag) {
+    typedef __segmented_iterator_traits<SegIter> traits;
+    typename traits::segment_iterator sfirst = traits::segment(first);
+    typename traits::segment_iterator slast = traits::segment(last);
+    if(sfirst == slast) {
+        return __accumulate(traits::local(first), traits::local(last), begin, __non_segmented_tag());
+    }
+    begin = __accumulate(traits::local(first), traits::end(sfirst), begin, __non_segmented_tag());
+    for(++sfirst; sfirst != slast; ++sfirst) {
+        begin = __accumulate(traits::begin(sfirst), traits::end(sfirst), begin, __non_segmented_tag());
+    }
+    return __accumulate(traits::begin(slast), traits::local(last), begin, __non_segmented_tag());
+}
+
+template <class InputIterator, class T>
+T accumulate(InputIterator first, InputIterator last, T begin) {
+    return __accumulate(first, last, begin, __segmented_category(first));
+}
+
 template <class InputIterator, class T, class BinaryOps>
-T accumulate(InputIterator first, InputIterator last, T begin, BinaryOps bo = plus<int>()) {
+T __accumulate(InputIterator first, InputIterator last, T begin, BinaryOps bo, __non_segmented_tag) {
     for(; first != last; ++first) {
         begin = bo(begin, *first);
     }
     return begin;
 }
 
+template <class SegIter, class T, class BinaryOps>
+T __accumulate(SegIter first, SegIter last, T begin, BinaryOps bo, __segmented_tag) {
+    typedef __segmented_iterator_traits<SegIter> traits;
+    typename traits::segment_iterator sfirst = traits::segment(first);
+    typename traits::segment_iterator slast = traits::segment(last);
+    if(sfirst == slast) {
+        return __accumulate(traits::local(first), traits::local(last), begin, bo, __non_segmented_tag());
+    }
+    begin = __accumulate(traits::local(first), traits::end(sfirst), begin, bo, __non_segmented_tag());
+    for(++sfirst; sfirst != slast; ++sfirst) {
+        begin = __accumulate(traits::begin(sfirst), traits::end(sfirst), begin, bo, __non_segmented_tag());
+    }
+    return __accumulate(traits::begin(slast), traits::local(last), begin, bo, __non_segmented_tag());
+}
+
+template <class InputIterator, class T, class BinaryOps>
+T accumulate(InputIterator first, InputIterator last, T begin, BinaryOps bo = plus<int>()) {
+    return __accumulate(first, last, begin, bo, __segmented_category(first));
+}
+
 template <class Iter1, class Iter2, class T>
 T inner_product(Iter1 first, Iter1 last, Iter2 begin, T init) {
     for(; first != last; ++begin, ++first) {
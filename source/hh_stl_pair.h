@@ -2,6 +2,7 @@
 #define __HH_STL_PAIR_H_
 
 #include "hh_stl_numeric.h"
+#include<utility>
 
 namespace hh_std {
 
@@ -13,19 +14,36 @@ struct pair {
     T2 second;
     pair(): first(T1()), second(T2()) {}
     pair(const T1 &x, const T2 &y): first((T1&)x), second(y) {}
-    pair(const pair<T1, T2> &x): first(x.first), second(x.second) {}
+    pair(const pair<T1, T2> &x) = default;
+    pair(pair<T1, T2> &&x) = default;
+    template <class U1, class U2>
+    pair(U1 &&x, U2 &&y): first(std::forward<U1>(x)), second(std::forward<U2>(y)) {}
+    template <class U1, class U2>
+    pair(const pair<U1, U2> &x): first(x.first), second(x.second) {}
+    template <class U1, class U2>
+    pair(pair<U1, U2> &&x): first(std::forward<U1>(x.first)), second(std::forward<U2>(x.second)) {}
+    pair<T1, T2> &operator= (const pair<T1, T2> &x) = default;
+    pair<T1, T2> &operator= (pair<T1, T2> &&x) = default;
 };
 
 template <class T1, class T2>
-inline bool operator== (pair<T1, T2> &x, pair<T1, T2> &y) {
+inline bool operator== (const pair<T1, T2> &x, const pair<T1, T2> &y) {
     return x.first == y.first && x.second == y.second;
 }
 
 template <class T1, class T2>
-inline bool operator< (pair<T1, T2> &x, pair<T1, T2> &y) {
+inline bool operator< (const pair<T1, T2> &x, const pair<T1, T2> &y) {
     return x.first < y.first ? true : (x.first == y.first ? x.second < y.second : false);
 }
 
+// More specialized than both the generic std::swap and hh_std::swap, so ADL
+// calls inside std::sort and friends are not ambiguous.
+template <class T1, class T2>
+inline void swap(pair<T1, T2> &x, pair<T1, T2> &y) {
+    std::swap(x.first, y.first);
+    std::swap(x.second, y.second);
+}
+
 template <class T1, class T2>
 pair<T1, T2> make_pair(const T1 &x, const T2 &y) {
     return pair<T1, T2>(x, y);
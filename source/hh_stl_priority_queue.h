@@ -43,6 +43,15 @@ public:
         c.push_back(x);
         hh_std::push_heap(c.begin(), c.end(), comp);
     }
+    void push(value_type &&x) {
+        c.push_back(std::move(x));
+        hh_std::push_heap(c.begin(), c.end(), comp);
+    }
+    template <class... Args>
+    void emplace(Args&&... args) {
+        c.emplace_back(std::forward<Args>(args)...);
+        hh_std::push_heap(c.begin(), c.end(), comp);
+    }
     void pop() {
         hh_std::pop_heap(c.begin(), c.end(), comp);
         c.pop_back();
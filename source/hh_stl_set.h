@@ -41,6 +41,7 @@ public:
     typedef typename rep_type::const_iterator const_iterator;
     typedef typename rep_type::const_r_iterator r_iterator;
     typedef typename rep_type::const_r_iterator const_r_iterator;
+    typedef typename rep_type::allocator_type allocator_type;
     set(): t(Compare()) {}
     explicit set(const Compare &comp): t(comp) {}
     template <class InputIterator>
@@ -51,11 +52,20 @@ public:
     set(InputIterator first, InputIterator last, const Compare &comp): t(comp) {
         t.insert_unique(first, last);
     }
+    set(const Compare &c, const allocator_type &a): t(c, a) {}
     set(const set<Key, Compare, Alloc> &x): t(x.t) {}
     set<Key, Compare, Alloc> &operator= (const set<Key, Compare, Alloc> &x) {
         t = x.t;
         return *this;
     }
+    set(set<Key, Compare, Alloc> &&x): t(std::move(x.t)) {}
+    set<Key, Compare, Alloc> &operator= (set<Key, Compare, Alloc> &&x) {
+        t = std::move(x.t);
+        return *this;
+    }
+    allocator_type get_allocator() const {
+        return t.get_allocator();
+    }
     key_compare key_comp() const {
         return t.comp;
     }
@@ -90,8 +100,24 @@ public:
         hh_std::pair<typename rep_type::iterator, bool> result = t.insert_unique(x);
         return hh_std::make_pair(iterator(result.first.node), result.second);
     }
+    hh_std::pair<iterator, bool> insert(value_type &&x) {
+        hh_std::pair<typename rep_type::iterator, bool> result = t.insert_unique(std::move(x));
+        return hh_std::make_pair(iterator(result.first.node), result.second);
+    }
     iterator insert(iterator pos, const value_type &x) {
-        return t.insert((typename rep_type::iterator)pos, x);
+        return iterator(t.insert_unique(typename rep_type::iterator(pos.node), x).node);
+    }
+    iterator insert(iterator pos, value_type &&x) {
+        return iterator(t.insert_unique(typename rep_type::iterator(pos.node), std::move(x)).node);
+    }
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace(Args&&... args) {
+        hh_std::pair<typename rep_type::iterator, bool> result = t.emplace_unique(std::forward<Args>(args)...);
+        return hh_std::make_pair(iterator(result.first.node), result.second);
+    }
+    template <class... Args>
+    iterator emplace_hint(iterator pos, Args&&... args) {
+        return iterator(t.emplace_hint_unique(typename rep_type::iterator(pos.node), std::forward<Args>(args)...).node);
     }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) {
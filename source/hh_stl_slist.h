@@ -2,6 +2,7 @@
 #define __HH_STL_SLIST_H_
 
 #include<cstddef>
+#include<utility>
 #include "hh_stl_iterator.h"
 #include "hh_stl_alloc.h"
 #include "hh_config.h"
@@ -52,9 +53,10 @@ inline void __slist_splice_after(__slist_node_base *pos, __slist_node_base *befo
 }
 
 inline __slist_node_base *__slist_reverse(__slist_node_base *node) {
-    if(!node && !node->next) return node;
+    if(!node || !node->next) return node;
     __slist_node_base *result = node, *next_node;
     node = node->next;
+    result->next = 0;
     while(node) {
         next_node = node->next;
         node->next = result;
@@ -101,7 +103,7 @@ struct __slist_iterator: public __slist_iterator_base {
 
     __slist_iterator(list_node *x): __slist_iterator_base(x) {}
     __slist_iterator(): __slist_iterator_base(0) {}
-    __slist_iterator(const_iterator &x): __slist_iterator_base(x.node) {}
+    __slist_iterator(const iterator &x): __slist_iterator_base(x.node) {}
 
     reference operator* () const {
         return ((list_node*)node)->data;
@@ -117,8 +119,8 @@ struct __slist_iterator: public __slist_iterator_base {
     }
 
     self operator++ (int) {
-        __slist_iterator tmp = *this;
-        tmp.incr();
+        self tmp = *this;
+        incr();
         return tmp;
     }
 };
@@ -139,7 +141,7 @@ bool operator== (const slist<T, Alloc> &l, const slist<T, Alloc> &l2) {
 }
 
 template <class T, class Alloc = alloc>
-class slist {
+class slist: private __alloc_holder<Alloc> {
 public:
     typedef T value_type;
     typedef T* pointer;
@@ -148,6 +150,7 @@ public:
     typedef const T& const_reference;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 
     typedef __slist_iterator<T, T&, T*> iterator;
     typedef __slist_iterator<T, const T&, const T*> const_iterator;
@@ -155,24 +158,49 @@ private:
     typedef __slist_node_base list_node_base;
     typedef __slist_node<T> list_node;
     typedef __slist_iterator_base iterator_base;
+    typedef __alloc_holder<Alloc> alloc_base;
     typedef hh_std::simple_alloc<list_node, Alloc> data_allocate;
 
     list_node_base head;
 
-    static list_node * create_node(const value_type & x) {
-        list_node *result;
+    template <class... Args>
+    list_node * create_node(Args&&... args) {
+        list_node *result = data_allocate::allocate(this->get_alloc());
         __STL_TRY {
-            result = data_allocate::allocate();
-            construct(&(result->data), x);
+            construct(&(result->data), std::forward<Args>(args)...);
             result->next = 0;
         }
-        __STL_UNWIND(data_allocate::deallocate(result));
+        __STL_UNWIND(data_allocate::deallocate(this->get_alloc(), result));
         return result;
     }
 
-    static void destroy_node(list_node * x) {
+    void destroy_node(list_node * x) {
         destory(&(x->data));
-        data_allocate::deallocate(x);
+        data_allocate::deallocate(this->get_alloc(), x);
+    }
+
+    void copy_assign_alloc(const slist & l, __true_type) {
+        clear();
+        this->get_alloc() = l.get_alloc();
+    }
+
+    void copy_assign_alloc(const slist &, __false_type) {
+    }
+
+    void move_assign(slist & l, __true_type) {
+        clear();
+        this->get_alloc() = l.get_alloc();
+        head.next = l.head.next;
+        l.head.next = 0;
+    }
+
+    void move_assign(slist & l, __false_type) {
+        clear();
+        list_node_base *prev = &head;
+        for(list_node_base *cur = l.head.next; cur; cur = cur->next) {
+            prev = __slist_make_link(prev, create_node(std::move(((list_node*)cur)->data)));
+        }
+        l.clear();
     }
 
     void fill_initialize(size_type n, const value_type & x) {
@@ -206,8 +234,9 @@ private:
         }
     }
 
-    list_node * __insert_after(__slist_node_base * node, const value_type & x) {
-        return (list_node*)__slist_make_link(node, create_node(x));
+    template <class... Args>
+    list_node * __insert_after(__slist_node_base * node, Args&&... args) {
+        return (list_node*)__slist_make_link(node, create_node(std::forward<Args>(args)...));
     }
 
     list_node_base * erase_after(__slist_node_base * node) {
@@ -231,56 +260,65 @@ public:
     slist() {
         head.next = 0;
     }
-    slist(size_type n, const value_type & x) {
+    explicit slist(const allocator_type & a): alloc_base(a) {
+        head.next = 0;
+    }
+    slist(size_type n, const value_type & x, const allocator_type & a = allocator_type()): alloc_base(a) {
         fill_initialize(n, x);
     }
-    slist(int n, const value_type & x) {
+    slist(int n, const value_type & x, const allocator_type & a = allocator_type()): alloc_base(a) {
         fill_initialize(n, x);
     }
-    slist(long n, const value_type & x) {
+    slist(long n, const value_type & x, const allocator_type & a = allocator_type()): alloc_base(a) {
         fill_initialize(n, x);
     }
     explicit slist(size_type n) {
         fill_initialize(n, value_type());
     }
     template <class InputIterator>
-    slist(InputIterator first, InputIterator last) {
+    slist(InputIterator first, InputIterator last, const allocator_type & a = allocator_type()): alloc_base(a) {
         range_initialize(first, last);
     }
-    slist(const slist & l) {
+    slist(const slist & l):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(l.get_alloc())) {
         range_initialize(l.begin(), l.end());
     }
+    slist(slist && l): alloc_base(l.get_alloc()) {
+        head.next = l.head.next;
+        l.head.next = 0;
+    }
+    slist &operator= (slist && l) {
+        if(this != &l) {
+            move_assign(l, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
     slist &operator= (const slist & l) {
-        if(*this != l) {
-            iterator first = begin(), first_l = l.begin();
-            iterator last = end(), last_l = l.end();
-            __slist_node_base *node;
-            while(first != last && first_l != last_l) {
-                destory(&*first);
-                construct(&*first, *first_l);
+        if(this != &l) {
+            copy_assign_alloc(l, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            list_node_base *prev = &head;
+            const list_node_base *cur_l = l.head.next;
+            while(prev->next && cur_l) {
+                ((list_node*)prev->next)->data = ((const list_node*)cur_l)->data;
+                prev = prev->next;
+                cur_l = cur_l->next;
             }
-            if(first != last) {
-                node = __slist_previous(&head, &*first);
-                __slist_node_base *tmp;
-                while(node->next) {
-                    tmp = node->next;
-                    node->next = node->next->next;
-                    destroy_node(tmp);
-                }
+            if(prev->next) {
+                erase_after(prev, 0);
             }
-            if(first_l != last_l) {
-                node = __slist_previous(&head, &*first);
-                while(first_l != last_l) {
-                    node = __slist_make_link(node, create_node(*first_l));
-                    ++first_l;
-                }
+            while(cur_l) {
+                prev = __slist_make_link(prev, create_node(((const list_node*)cur_l)->data));
+                cur_l = cur_l->next;
             }
-            return *this;
         }
+        return *this;
     }
     ~slist() {
         clear();
     }
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
     iterator begin() {
         return iterator((list_node*)head.next);
     }
@@ -303,6 +341,8 @@ public:
         return head.next == 0;
     }
     void swap(slist & l) {
+        __alloc_swap(this->get_alloc(), l.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
         std::swap(head, l.head);
     }
     void clear() {
@@ -322,6 +362,13 @@ public:
     void push_front(const value_type & x) {
         __slist_make_link(&head, create_node(x));
     }
+    void push_front(value_type && x) {
+        __slist_make_link(&head, create_node(std::move(x)));
+    }
+    template <class... Args>
+    void emplace_front(Args&&... args) {
+        __slist_make_link(&head, create_node(std::forward<Args>(args)...));
+    }
     void pop_front() {
         list_node *node = (list_node*)head.next;
         head.next = (head.next)->next;
@@ -336,6 +383,13 @@ public:
     iterator insert_after(iterator pos, const value_type & x) {
         return iterator(__insert_after(pos.node, x));
     }
+    iterator insert_after(iterator pos, value_type && x) {
+        return iterator(__insert_after(pos.node, std::move(x)));
+    }
+    template <class... Args>
+    iterator emplace_after(iterator pos, Args&&... args) {
+        return iterator(__insert_after(pos.node, std::forward<Args>(args)...));
+    }
     iterator insert_after(iterator pos) {
         return iterator(__insert_after(pos.node, value_type()));
     }
@@ -355,6 +409,13 @@ public:
     iterator insert(iterator pos, const value_type & x) {
         return iterator(__insert_after(__slist_previous(&head, pos.node), x));
     }
+    iterator insert(iterator pos, value_type && x) {
+        return iterator(__insert_after(__slist_previous(&head, pos.node), std::move(x)));
+    }
+    template <class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
+        return iterator(__insert_after(__slist_previous(&head, pos.node), std::forward<Args>(args)...));
+    }
     iterator insert(iterator pos) {
         return iterator(__insert_after(__slist_previous(&head, pos.node), value_type()));
     }
@@ -395,7 +456,7 @@ public:
     }
     void splice_after(iterator pos, slist & l) {
         if(l.head.next) {
-            __slist_splice_after(pos.node, l.head, __slist_previous(&(l.head), 0));
+            __slist_splice_after(pos.node, &(l.head), __slist_previous(&(l.head), 0));
         }
     }
     void splice_after(iterator pos, slist & l, iterator i) {
@@ -484,7 +545,7 @@ public:
             if(i == fill) fill++;
         }
         for(size_type i = 0; i < fill; ++i) {
-            merge(counts[i]);
+            merge(counts[i], order);
         }
     }
     void sort() {
@@ -506,7 +567,7 @@ public:
 };
 
 template <class T, class Alloc>
-inline void swap(const slist<T, Alloc> &l, const slist<T, Alloc> &l2) {
+inline void swap(slist<T, Alloc> &l, slist<T, Alloc> &l2) {
     l.swap(l2);
 }
 
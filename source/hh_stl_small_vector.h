@@ -0,0 +1,480 @@
+#ifndef __HH_STL_SMALL_VECTOR_H_
+#define __HH_STL_SMALL_VECTOR_H_
+
+#include<cstddef>
+#include<cstring>
+#include<algorithm>
+#include<utility>
+#include<type_traits>
+#include "hh_stl_iterator.h"
+#include "hh_stl_alloc.h"
+#include "hh_stl_uninitialized.h"
+
+namespace hh_std {
+
+// A vector that keeps its first N elements in an inline buffer and only
+// asks Alloc for memory once it grows past N.  Iterators are plain pointers,
+// as in vector, so every algorithm that works on vector works here.
+// Moving or swapping an inline small_vector moves its elements one by one.
+template <class T, size_t N, class Alloc = alloc>
+class small_vector: private __alloc_holder<Alloc> {
+    static_assert(N > 0, "small_vector needs room for at least one inline element");
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type* iterator;
+    typedef const value_type* const_iterator;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+    typedef reverse_iterator<const_iterator>  const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef simple_alloc<value_type, Alloc> data_allocator;
+    typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+
+    iterator start;
+    iterator finish;
+    iterator end_of_storage;
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buffer;
+
+    iterator inline_start() {
+        return reinterpret_cast<iterator>(&buffer);
+    }
+    const_iterator inline_start() const {
+        return reinterpret_cast<const_iterator>(&buffer);
+    }
+    void reset_inline() {
+        start = finish = inline_start();
+        end_of_storage = start + N;
+    }
+    void deallocate() {
+        if(!is_inline()) {
+            data_allocator::deallocate(this->get_alloc(), start, end_of_storage - start);
+        }
+    }
+
+    // Moves [first, last) into raw storage at dest and ends the lifetime of
+    // the source elements.
+    static iterator relocate(iterator first, iterator last, iterator dest, __true_type) {
+        memcpy((void*)dest, (void*)first, (last - first) * sizeof(T));
+        return dest + (last - first);
+    }
+    static iterator relocate(iterator first, iterator last, iterator dest, __false_type) {
+        iterator result = uninitialized_move(first, last, dest);
+        destory(first, last);
+        return result;
+    }
+
+    // Moves the elements into a heap block of new_capacity.
+    void grow(size_type new_capacity) {
+        iterator new_start = data_allocator::allocate(this->get_alloc(), new_capacity);
+        iterator new_finish;
+        try {
+            new_finish = relocate(start, finish, new_start, relocatable());
+        } catch(...) {
+            data_allocator::deallocate(this->get_alloc(), new_start, new_capacity);
+            throw;
+        }
+        deallocate();
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = start + new_capacity;
+    }
+    size_type next_capacity(size_type n) const {
+        size_type old = capacity();
+        return old * 2 > size() + n ? old * 2 : size() + n;
+    }
+
+    // Takes x's elements, stealing its heap block when it has one.
+    void steal(small_vector<T, N, Alloc> &x) {
+        if(x.is_inline()) {
+            finish = relocate(x.start, x.finish, start, relocatable());
+            x.finish = x.start;
+        } else {
+            start = x.start;
+            finish = x.finish;
+            end_of_storage = x.end_of_storage;
+            x.reset_inline();
+        }
+    }
+    void copy_assign_alloc(const small_vector<T, N, Alloc> &x, __true_type) {
+        clear();
+        deallocate();
+        reset_inline();
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const small_vector<T, N, Alloc> &, __false_type) {
+    }
+    void move_assign(small_vector<T, N, Alloc> &x, __true_type) {
+        clear();
+        deallocate();
+        reset_inline();
+        this->get_alloc() = x.get_alloc();
+        steal(x);
+    }
+    // The allocator stays put, so the elements have to be moved one by one.
+    void move_assign(small_vector<T, N, Alloc> &x, __false_type) {
+        clear();
+        reserve(x.size());
+        finish = uninitialized_move(x.start, x.finish, start);
+        x.clear();
+    }
+
+    template <class ForwardIterator>
+    void range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+        reserve(hh_std::distance(first, last));
+        finish = uninitialized_copy(first, last, start);
+    }
+    template <class InputIterator>
+    void range_initialize(InputIterator first, InputIterator last, input_iterator_tag) {
+        for(; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+    template <class ForwardIterator>
+    void range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+    template <class InputIterator>
+    void range_insert(iterator pos, InputIterator first, InputIterator last, input_iterator_tag) {
+        for(; first != last; ++first) {
+            pos = insert(pos, *first);
+            ++pos;
+        }
+    }
+public:
+    small_vector() {
+        reset_inline();
+    }
+    explicit small_vector(const allocator_type &a): alloc_base(a) {
+        reset_inline();
+    }
+    small_vector(size_type n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset_inline();
+        insert(finish, n, value);
+    }
+    small_vector(int n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset_inline();
+        insert(finish, size_type(n), value);
+    }
+    small_vector(long n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset_inline();
+        insert(finish, size_type(n), value);
+    }
+    explicit small_vector(size_type n) {
+        reset_inline();
+        insert(finish, n, T());
+    }
+    template <class InputIterator>
+    small_vector(InputIterator first, InputIterator last, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset_inline();
+        range_initialize(first, last, category_type(first));
+    }
+    small_vector(const small_vector<T, N, Alloc> &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())) {
+        reset_inline();
+        range_initialize(x.begin(), x.end(), category_type(x.begin()));
+    }
+    small_vector(small_vector<T, N, Alloc> &&x): alloc_base(x.get_alloc()) {
+        reset_inline();
+        steal(x);
+    }
+    ~small_vector() {
+        destory(start, finish);
+        deallocate();
+    }
+    small_vector<T, N, Alloc> &operator= (const small_vector<T, N, Alloc> &x) {
+        if(&x != this) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            clear();
+            reserve(x.size());
+            finish = uninitialized_copy(x.begin(), x.end(), start);
+        }
+        return *this;
+    }
+    small_vector<T, N, Alloc> &operator= (small_vector<T, N, Alloc> &&x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    // True while the elements still live in the inline buffer.
+    bool is_inline() const {
+        return start == inline_start();
+    }
+    static size_type inline_capacity() {
+        return N;
+    }
+    iterator begin() {
+        return start;
+    }
+    const_iterator begin() const {
+        return start;
+    }
+    iterator end() {
+        return finish;
+    }
+    const_iterator end() const {
+        return finish;
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    size_type size() const {
+        return finish - start;
+    }
+    size_type max_size() const {
+        return size_type(-1) / sizeof(T);
+    }
+    size_type capacity() const {
+        return end_of_storage - start;
+    }
+    bool empty() const {
+        return finish == start;
+    }
+    reference at(size_type pos) {
+        return *(start + pos);
+    }
+    const_reference at(size_type pos) const {
+        return *(start + pos);
+    }
+    reference operator[] (size_type n) {
+        return *(start + n);
+    }
+    const_reference operator[] (size_type n) const {
+        return *(start + n);
+    }
+    reference front() {
+        return *start;
+    }
+    const_reference front() const {
+        return *start;
+    }
+    reference back() {
+        return *(finish - 1);
+    }
+    const_reference back() const {
+        return *(finish - 1);
+    }
+    void reserve(size_type n) {
+        if(n > capacity()) {
+            grow(n);
+        }
+    }
+    void push_back(const T &x) {
+        emplace_back(x);
+    }
+    void push_back(T &&x) {
+        emplace_back(std::move(x));
+    }
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        if(finish != end_of_storage) {
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
+        } else {
+            T x_copy(std::forward<Args>(args)...);  // args may refer into the old storage
+            grow(next_capacity(1));
+            construct(finish, std::move(x_copy));
+            ++finish;
+        }
+    }
+    void pop_back() {
+        --finish;
+        destory(finish);
+    }
+    iterator insert(iterator pos, const T &x) {
+        return emplace(pos, x);
+    }
+    iterator insert(iterator pos, T &&x) {
+        return emplace(pos, std::move(x));
+    }
+    template <class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
+        size_type n = pos - start;
+        if(pos == finish) {
+            emplace_back(std::forward<Args>(args)...);
+        } else {
+            T x_copy(std::forward<Args>(args)...);
+            if(finish == end_of_storage) {
+                grow(next_capacity(1));
+                pos = start + n;
+            }
+            construct(finish, std::move(*(finish - 1)));
+            ++finish;
+            std::move_backward(pos, finish - 2, finish - 1);
+            *pos = std::move(x_copy);
+        }
+        return start + n;
+    }
+    void insert(iterator pos, size_type n, const T &x);
+    void insert(iterator pos, int n, const T &x) {
+        insert(pos, size_type(n), x);
+    }
+    void insert(iterator pos, long n, const T &x) {
+        insert(pos, size_type(n), x);
+    }
+    template <class InputIterator>
+    void insert(iterator pos, InputIterator first, InputIterator last) {
+        range_insert(pos, first, last, category_type(first));
+    }
+    iterator erase(iterator pos) {
+        if(pos + 1 != finish) {
+            std::move(pos + 1, finish, pos);
+        }
+        --finish;
+        destory(finish);
+        return pos;
+    }
+    iterator erase(iterator first, iterator last) {
+        if(first == last) {
+            return first;
+        }
+        iterator new_finish = std::move(last, finish, first);
+        destory(new_finish, finish);
+        finish = new_finish;
+        return first;
+    }
+    void resize(size_type new_size, const T &x) {
+        if(new_size < size()) {
+            erase(start + new_size, finish);
+        } else if(new_size > size()) {
+            insert(finish, new_size - size(), x);
+        }
+    }
+    void resize(size_type new_size) {
+        resize(new_size, T());
+    }
+    void clear() {
+        destory(start, finish);
+        finish = start;
+    }
+    // Moves the elements back into the inline buffer when they fit, or into
+    // a heap block of exactly size() otherwise.
+    void shrink_to_fit() {
+        if(is_inline() || size() == capacity()) {
+            return;
+        }
+        if(size() <= N) {
+            iterator old_start = start, old_finish = finish, old_end = end_of_storage;
+            start = inline_start();
+            finish = relocate(old_start, old_finish, start, relocatable());
+            end_of_storage = start + N;
+            data_allocator::deallocate(this->get_alloc(), old_start, old_end - old_start);
+        } else {
+            grow(size());
+        }
+    }
+    void swap(small_vector<T, N, Alloc> &x) {
+        small_vector<T, N, Alloc> tmp(std::move(x));
+        x = std::move(*this);
+        *this = std::move(tmp);
+    }
+};
+
+template <class T, size_t N, class Alloc>
+template <class ForwardIterator>
+void small_vector<T, N, Alloc>::range_insert(iterator pos, ForwardIterator first, ForwardIterator last,
+                                             forward_iterator_tag) {
+    size_type n = hh_std::distance(first, last);
+    if(n == 0) {
+        return;
+    }
+    if(n > size_type(end_of_storage - finish)) {
+        size_type off = pos - start;
+        grow(next_capacity(n));
+        pos = start + off;
+    }
+    size_type elems_after = finish - pos;
+    if(elems_after > n) {
+        uninitialized_move(finish - n, finish, finish);
+        std::move_backward(pos, finish - n, finish);
+        std::copy(first, last, pos);
+    } else {
+        ForwardIterator mid = first;
+        hh_std::advance(mid, elems_after);
+        iterator new_finish = uninitialized_copy(mid, last, finish);
+        uninitialized_move(pos, finish, new_finish);
+        std::copy(first, mid, pos);
+    }
+    finish += n;
+}
+
+template <class T, size_t N, class Alloc>
+void small_vector<T, N, Alloc>::insert(iterator pos, size_type n, const T &x) {
+    if(n == 0) {
+        return;
+    }
+    T x_copy(x);    // x may live in the storage that is about to move
+    if(n > size_type(end_of_storage - finish)) {
+        size_type off = pos - start;
+        grow(next_capacity(n));
+        pos = start + off;
+    }
+    size_type elems_after = finish - pos;
+    if(elems_after > n) {
+        uninitialized_move(finish - n, finish, finish);
+        std::move_backward(pos, finish - n, finish);
+        std::fill_n(pos, n, x_copy);
+    } else {
+        uninitialized_fill_n(finish, n - elems_after, x_copy);
+        uninitialized_move(pos, finish, pos + n);
+        std::fill_n(pos, elems_after, x_copy);
+    }
+    finish += n;
+}
+
+template <class T, size_t N, class Alloc>
+inline bool operator== (const small_vector<T, N, Alloc> &a, const small_vector<T, N, Alloc> &b) {
+    if(a.size() != b.size())
+        return false;
+    for(typename small_vector<T, N, Alloc>::size_type i = 0; i < a.size(); i++) {
+        if(a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+template <class T, size_t N, class Alloc>
+inline bool operator!= (const small_vector<T, N, Alloc> &a, const small_vector<T, N, Alloc> &b) {
+    return !(a == b);
+}
+
+template <class T, size_t N, class Alloc>
+inline bool operator< (const small_vector<T, N, Alloc> &a, const small_vector<T, N, Alloc> &b) {
+    typename small_vector<T, N, Alloc>::size_type cur = 0;
+    while(cur < a.size() && cur < b.size()) {
+        if(a[cur] < b[cur])
+            return true;
+        else if(b[cur] < a[cur])
+            return false;
+        cur++;
+    }
+    return cur < b.size();
+}
+
+template <class T, size_t N, class Alloc>
+inline void swap(small_vector<T, N, Alloc> &a, small_vector<T, N, Alloc> &b) {
+    a.swap(b);
+}
+
+};
+
+#endif
@@ -0,0 +1,613 @@
+#ifndef __HH_STL_SOA_VECTOR_H_
+#define __HH_STL_SOA_VECTOR_H_
+
+#include<cstddef>
+#include<cstring>
+#include<tuple>
+#include<utility>
+#include<type_traits>
+#include "hh_stl_iterator.h"
+#include "hh_stl_alloc.h"
+#include "hh_stl_construct.h"
+#include "hh_stl_uninitialized.h"
+
+namespace hh_std {
+
+// soa_vector<Fields...> is a vector of records stored as one contiguous array
+// per field ("struct of arrays").  A loop that reads one field only pulls that
+// field's bytes through the cache.
+//
+// Element access goes through __soa_reference, a tuple of references to the
+// fields of one row, in the same way vector<bool> hands out __bit_reference.
+// value_type is std::tuple<Fields...>.  column<I>() returns a soa_span over
+// the raw array of field I for kernels that want plain pointers.
+//
+// The field pack has to come last, so the allocator is the first parameter of
+// basic_soa_vector and soa_vector<Fields...> is basic_soa_vector over alloc.
+
+template <size_t... I>
+struct __index_seq {};
+
+template <size_t N, size_t... I>
+struct __make_index_seq: __make_index_seq<N - 1, N - 1, I...> {};
+
+template <size_t... I>
+struct __make_index_seq<0, I...> {
+    typedef __index_seq<I...> type;
+};
+
+// Expands a pack of expressions left to right for their side effects.
+typedef int __soa_expand[];
+
+template <class T>
+struct soa_span {
+    typedef T value_type;
+    typedef T* iterator;
+    typedef size_t size_type;
+
+    T *first;
+    size_type n;
+
+    soa_span(T *p, size_type len): first(p), n(len) {}
+
+    T *data() const {
+        return first;
+    }
+    iterator begin() const {
+        return first;
+    }
+    iterator end() const {
+        return first + n;
+    }
+    size_type size() const {
+        return n;
+    }
+    bool empty() const {
+        return n == 0;
+    }
+    T &operator[] (size_type i) const {
+        return first[i];
+    }
+};
+
+template <class... Ts>
+struct __soa_reference {
+    typedef std::tuple<typename std::remove_const<Ts>::type...> value_type;
+    typedef typename __make_index_seq<sizeof...(Ts)>::type indices;
+
+    std::tuple<Ts&...> refs;
+
+    explicit __soa_reference(Ts&... x): refs(x...) {}
+    __soa_reference(const __soa_reference &x) = default;
+
+    operator value_type() const {
+        return value_type(refs);
+    }
+    template <size_t I>
+    typename std::tuple_element<I, std::tuple<Ts&...> >::type get() const {
+        return std::get<I>(refs);
+    }
+    // Assignment writes through to the row, as with a real reference.
+    // There is deliberately no move assignment from another reference:
+    // *dest = *src hands over a temporary proxy, and moving from it would
+    // empty the source row.
+    __soa_reference &operator= (const value_type &x) {
+        refs = x;
+        return *this;
+    }
+    __soa_reference &operator= (value_type &&x) {
+        refs = std::move(x);
+        return *this;
+    }
+    __soa_reference &operator= (const __soa_reference &x) {
+        refs = x.refs;
+        return *this;
+    }
+    void swap(const __soa_reference &x) const {
+        swap_aux(x, indices());
+    }
+    bool operator== (const __soa_reference &x) const {
+        return refs == x.refs;
+    }
+    bool operator< (const __soa_reference &x) const {
+        return refs < x.refs;
+    }
+private:
+    template <size_t... I>
+    void swap_aux(const __soa_reference &x, __index_seq<I...>) const {
+        using std::swap;
+        (void)__soa_expand{0, (swap(std::get<I>(refs), std::get<I>(x.refs)), 0)...};
+    }
+};
+
+template <class... Ts>
+inline void swap(__soa_reference<Ts...> x, __soa_reference<Ts...> y) {
+    x.swap(y);
+}
+
+// Holds a copy of the column base pointers plus a row index, so moving the
+// container does not invalidate its iterators.  Ts are const-qualified for
+// const_iterator.
+template <class... Ts>
+struct __soa_iterator {
+    typedef random_access_iterator_tag iterator_category;
+    typedef std::tuple<typename std::remove_const<Ts>::type...> value_type;
+    typedef ptrdiff_t difference_type;
+    typedef __soa_reference<Ts...> reference;
+    typedef reference* pointer;
+    typedef __soa_iterator<Ts...> iterator;
+    typedef typename __make_index_seq<sizeof...(Ts)>::type indices;
+
+    std::tuple<Ts*...> cols;
+    difference_type idx;
+
+    __soa_iterator(): idx(0) {}
+    __soa_iterator(const std::tuple<Ts*...> &c, difference_type i): cols(c), idx(i) {}
+    // iterator -> const_iterator
+    template <class... Us>
+    __soa_iterator(const __soa_iterator<Us...> &x): cols(x.cols), idx(x.idx) {}
+
+    reference operator* () const {
+        return deref(idx, indices());
+    }
+    reference operator[] (difference_type i) const {
+        return deref(idx + i, indices());
+    }
+    iterator &operator++ () {
+        ++idx;
+        return *this;
+    }
+    iterator operator++ (int) {
+        iterator tmp = *this;
+        ++idx;
+        return tmp;
+    }
+    iterator &operator-- () {
+        --idx;
+        return *this;
+    }
+    iterator operator-- (int) {
+        iterator tmp = *this;
+        --idx;
+        return tmp;
+    }
+    iterator &operator+= (difference_type i) {
+        idx += i;
+        return *this;
+    }
+    iterator &operator-= (difference_type i) {
+        idx -= i;
+        return *this;
+    }
+    iterator operator+ (difference_type i) const {
+        return iterator(cols, idx + i);
+    }
+    iterator operator- (difference_type i) const {
+        return iterator(cols, idx - i);
+    }
+    difference_type operator- (const iterator &x) const {
+        return idx - x.idx;
+    }
+    bool operator== (const iterator &x) const {
+        return idx == x.idx;
+    }
+    bool operator!= (const iterator &x) const {
+        return idx != x.idx;
+    }
+    bool operator< (const iterator &x) const {
+        return idx < x.idx;
+    }
+    bool operator> (const iterator &x) const {
+        return idx > x.idx;
+    }
+    bool operator<= (const iterator &x) const {
+        return idx <= x.idx;
+    }
+    bool operator>= (const iterator &x) const {
+        return idx >= x.idx;
+    }
+private:
+    template <size_t... I>
+    reference deref(difference_type i, __index_seq<I...>) const {
+        return reference(std::get<I>(cols)[i]...);
+    }
+};
+
+template <class... Ts>
+inline __soa_iterator<Ts...> operator+ (ptrdiff_t n, const __soa_iterator<Ts...> &x) {
+    return x + n;
+}
+
+template <class Alloc, class... Fields>
+class basic_soa_vector: private __alloc_holder<Alloc> {
+    static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+public:
+    typedef std::tuple<Fields...> value_type;
+    typedef __soa_reference<Fields...> reference;
+    typedef __soa_reference<const Fields...> const_reference;
+    typedef __soa_iterator<Fields...> iterator;
+    typedef __soa_iterator<const Fields...> const_iterator;
+    typedef reverse_iterator<const_iterator> const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+    template <size_t I>
+    struct column_type {
+        typedef typename std::tuple_element<I, value_type>::type type;
+    };
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef typename __make_index_seq<sizeof...(Fields)>::type indices;
+
+    std::tuple<Fields*...> cols;
+    size_type len;
+    size_type cap;
+
+    template <class T>
+    T *allocate_column(size_type n) {
+        return n == 0 ? 0 : simple_alloc<T, Alloc>::allocate(this->get_alloc(), n);
+    }
+    template <class T>
+    void deallocate_column(T *p, size_type n) {
+        if(p) {
+            simple_alloc<T, Alloc>::deallocate(this->get_alloc(), p, n);
+        }
+    }
+    // Relocation runs in three steps so that a throw in a later column can be
+    // undone: build_column fills the new column while the old one stays
+    // alive, and once every column is built retire_column ends the old ones.
+    // If a column throws, restore_column puts the columns already built back.
+    template <class T>
+    static void build_column(T *from, T *to, size_type n, __true_type) {
+        if(n != 0) {
+            std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), n * sizeof(T));
+        }
+    }
+    template <class T>
+    static void build_column(T *from, T *to, size_type n, __false_type) {
+        uninitialized_move_if_noexcept(from, from + n, to);
+    }
+    template <class T>
+    static void retire_column(T*, size_type, __true_type) {
+    }
+    template <class T>
+    static void retire_column(T *from, size_type n, __false_type) {
+        destory(from, from + n);
+    }
+    // The bytes were copied, so the old column still owns the elements.
+    template <class T>
+    static void restore_column(T*, T*, size_type, __true_type) {
+    }
+    // A nothrow move was taken, so it is safe to move the elements back.
+    template <class T>
+    static void restore_column(T *from, T *to, size_type n, __false_type) {
+        if(std::is_nothrow_move_constructible<T>::value) {
+            for(size_type i = 0; i < n; ++i) {
+                destory(from + i);
+                construct(from + i, std::move(to[i]));
+            }
+        }
+        destory(to, to + n);
+    }
+    template <class T>
+    static int build_column(T *from, T *to, size_type n) {
+        build_column(from, to, n, typename __type_traits<T>::is_trivially_relocatable());
+        return 0;
+    }
+    template <class T>
+    static int retire_column(T *from, size_type n) {
+        retire_column(from, n, typename __type_traits<T>::is_trivially_relocatable());
+        return 0;
+    }
+    template <class T>
+    static int restore_column(T *from, T *to, size_type n) {
+        restore_column(from, to, n, typename __type_traits<T>::is_trivially_relocatable());
+        return 0;
+    }
+    template <class T>
+    static int destroy_column(T *p, size_type first, size_type last) {
+        destory(p + first, p + last);
+        return 0;
+    }
+    template <class T>
+    static int erase_column(T *p, size_type first, size_type last, size_type n) {
+        if(first == last) {
+            return 0;
+        }
+        std::move(p + last, p + n, p + first);
+        destory(p + n - (last - first), p + n);
+        return 0;
+    }
+
+    template <size_t... I>
+    void reallocate(size_type new_cap, __index_seq<I...>) {
+        std::tuple<Fields*...> new_cols;
+        size_type built = 0;
+        try {
+            (void)__soa_expand{0, (std::get<I>(new_cols) = allocate_column<Fields>(new_cap), 0)...};
+            (void)__soa_expand{0, (build_column(std::get<I>(cols), std::get<I>(new_cols), len), ++built, 0)...};
+        } catch(...) {
+            (void)__soa_expand{0, (I < built ? restore_column(std::get<I>(cols), std::get<I>(new_cols), len) : 0)...};
+            (void)__soa_expand{0, (deallocate_column(std::get<I>(new_cols), new_cap), 0)...};
+            throw;
+        }
+        (void)__soa_expand{0, retire_column(std::get<I>(cols), len)...};
+        (void)__soa_expand{0, (deallocate_column(std::get<I>(cols), cap), 0)...};
+        cols = new_cols;
+        cap = new_cap;
+    }
+    void grow_for(size_type n) {
+        if(n > cap) {
+            size_type new_cap = cap == 0 ? 1 : 2 * cap;
+            reallocate(new_cap < n ? n : new_cap, indices());
+        }
+    }
+    template <size_t... I>
+    void deallocate(__index_seq<I...>) {
+        (void)__soa_expand{0, destroy_column(std::get<I>(cols), 0, len)...};
+        (void)__soa_expand{0, (deallocate_column(std::get<I>(cols), cap), 0)...};
+    }
+    // The fields are constructed column by column; if one throws, the fields
+    // already built are destroyed again and the size stays as it was.
+    // x is always a whole value_type, so it cannot alias the columns.
+    template <class V, size_t... I>
+    void append(V &&x, __index_seq<I...>) {
+        grow_for(len + 1);
+        size_type built = 0;
+        try {
+            (void)__soa_expand{0, (construct(std::get<I>(cols) + len, std::get<I>(std::forward<V>(x))), ++built, 0)...};
+        } catch(...) {
+            (void)__soa_expand{0, (I < built ? destroy_column(std::get<I>(cols), len, len + 1) : 0)...};
+            throw;
+        }
+        ++len;
+    }
+    template <size_t... I>
+    void copy_from(const basic_soa_vector &x, __index_seq<I...>) {
+        cols = std::tuple<Fields*...>(allocate_column<Fields>(x.len)...);
+        cap = x.len;
+        (void)__soa_expand{0, (uninitialized_copy(std::get<I>(x.cols), std::get<I>(x.cols) + x.len, std::get<I>(cols)), 0)...};
+        len = x.len;
+    }
+    template <size_t... I>
+    void move_from(basic_soa_vector &x, __index_seq<I...>) {
+        cols = std::tuple<Fields*...>(allocate_column<Fields>(x.len)...);
+        cap = x.len;
+        (void)__soa_expand{0, (uninitialized_move(std::get<I>(x.cols), std::get<I>(x.cols) + x.len, std::get<I>(cols)), 0)...};
+        len = x.len;
+    }
+    template <size_t... I>
+    void erase_rows(size_type first, size_type last, __index_seq<I...>) {
+        (void)__soa_expand{0, erase_column(std::get<I>(cols), first, last, len)...};
+        len -= last - first;
+    }
+    template <size_t... I>
+    void truncate(size_type n, __index_seq<I...>) {
+        (void)__soa_expand{0, destroy_column(std::get<I>(cols), n, len)...};
+        len = n;
+    }
+    template <size_t... I>
+    reference row(size_type n, __index_seq<I...>) {
+        return reference(std::get<I>(cols)[n]...);
+    }
+    template <size_t... I>
+    const_reference row(size_type n, __index_seq<I...>) const {
+        return const_reference(std::get<I>(cols)[n]...);
+    }
+    std::tuple<const Fields*...> const_cols() const {
+        return std::tuple<const Fields*...>(cols);
+    }
+    void release() {
+        deallocate(indices());
+        cols = std::tuple<Fields*...>();
+        len = cap = 0;
+    }
+    void swap_data(basic_soa_vector &x) {
+        std::swap(cols, x.cols);
+        std::swap(len, x.len);
+        std::swap(cap, x.cap);
+    }
+
+    void copy_assign_alloc(const basic_soa_vector &x, __true_type) {
+        release();
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const basic_soa_vector&, __false_type) {
+    }
+    void move_assign(basic_soa_vector &x, __true_type) {
+        release();
+        this->get_alloc() = x.get_alloc();
+        swap_data(x);
+    }
+    // The allocator stays put, so the columns have to be moved element-wise.
+    void move_assign(basic_soa_vector &x, __false_type) {
+        basic_soa_vector tmp(this->get_alloc());
+        tmp.move_from(x, indices());
+        swap_data(tmp);
+        x.clear();
+    }
+public:
+    basic_soa_vector(): len(0), cap(0) {}
+    explicit basic_soa_vector(const allocator_type &a): alloc_base(a), len(0), cap(0) {}
+    explicit basic_soa_vector(size_type n, const allocator_type &a = allocator_type()): alloc_base(a), len(0), cap(0) {
+        resize(n);
+    }
+    basic_soa_vector(const basic_soa_vector &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())), len(0), cap(0) {
+        copy_from(x, indices());
+    }
+    basic_soa_vector(basic_soa_vector &&x): alloc_base(x.get_alloc()), cols(x.cols), len(x.len), cap(x.cap) {
+        x.cols = std::tuple<Fields*...>();
+        x.len = x.cap = 0;
+    }
+    basic_soa_vector &operator= (const basic_soa_vector &x) {
+        if(&x != this) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            basic_soa_vector tmp(this->get_alloc());
+            tmp.copy_from(x, indices());
+            swap_data(tmp);
+        }
+        return *this;
+    }
+    basic_soa_vector &operator= (basic_soa_vector &&x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+    ~basic_soa_vector() {
+        deallocate(indices());
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+
+    iterator begin() {
+        return iterator(cols, 0);
+    }
+    const_iterator begin() const {
+        return const_iterator(const_cols(), 0);
+    }
+    iterator end() {
+        return iterator(cols, len);
+    }
+    const_iterator end() const {
+        return const_iterator(const_cols(), len);
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    size_type size() const {
+        return len;
+    }
+    size_type capacity() const {
+        return cap;
+    }
+    bool empty() const {
+        return len == 0;
+    }
+    reference operator[] (size_type n) {
+        return row(n, indices());
+    }
+    const_reference operator[] (size_type n) const {
+        return row(n, indices());
+    }
+    reference front() {
+        return row(0, indices());
+    }
+    const_reference front() const {
+        return row(0, indices());
+    }
+    reference back() {
+        return row(len - 1, indices());
+    }
+    const_reference back() const {
+        return row(len - 1, indices());
+    }
+
+    // Column I as one contiguous array of size() elements.
+    template <size_t I>
+    soa_span<typename column_type<I>::type> column() {
+        return soa_span<typename column_type<I>::type>(std::get<I>(cols), len);
+    }
+    template <size_t I>
+    soa_span<const typename column_type<I>::type> column() const {
+        return soa_span<const typename column_type<I>::type>(std::get<I>(cols), len);
+    }
+    template <size_t I>
+    typename column_type<I>::type *data() {
+        return std::get<I>(cols);
+    }
+    template <size_t I>
+    const typename column_type<I>::type *data() const {
+        return std::get<I>(cols);
+    }
+
+    void reserve(size_type n) {
+        if(n > cap) {
+            reallocate(n, indices());
+        }
+    }
+    void push_back(const value_type &x) {
+        append(x, indices());
+    }
+    void push_back(value_type &&x) {
+        append(std::move(x), indices());
+    }
+    // One argument per field.
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        append(value_type(std::forward<Args>(args)...), indices());
+    }
+    void pop_back() {
+        truncate(len - 1, indices());
+    }
+    iterator erase(iterator pos) {
+        erase_rows(pos.idx, pos.idx + 1, indices());
+        return iterator(cols, pos.idx);
+    }
+    iterator erase(iterator first, iterator last) {
+        erase_rows(first.idx, last.idx, indices());
+        return iterator(cols, first.idx);
+    }
+    void resize(size_type n, const value_type &x = value_type()) {
+        if(n < len) {
+            truncate(n, indices());
+        } else {
+            reserve(n);
+            while(len < n) {
+                append(x, indices());
+            }
+        }
+    }
+    void clear() {
+        truncate(0, indices());
+    }
+    void swap(basic_soa_vector &x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        swap_data(x);
+    }
+};
+
+template <class... Fields>
+using soa_vector = basic_soa_vector<alloc, Fields...>;
+
+template <class Alloc, class... Fields>
+inline bool operator== (const basic_soa_vector<Alloc, Fields...> &a, const basic_soa_vector<Alloc, Fields...> &b) {
+    if(a.size() != b.size()) {
+        return false;
+    }
+    for(typename basic_soa_vector<Alloc, Fields...>::size_type i = 0; i < a.size(); i++) {
+        if(!(a[i] == b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Alloc, class... Fields>
+inline bool operator!= (const basic_soa_vector<Alloc, Fields...> &a, const basic_soa_vector<Alloc, Fields...> &b) {
+    return !(a == b);
+}
+
+template <class Alloc, class... Fields>
+inline void swap(basic_soa_vector<Alloc, Fields...> &a, basic_soa_vector<Alloc, Fields...> &b) {
+    a.swap(b);
+}
+
+};
+
+#endif
@@ -0,0 +1,510 @@
+#ifndef __HH_STL_STABLE_VECTOR_H_
+#define __HH_STL_STABLE_VECTOR_H_
+
+#include<cstddef>
+#include<utility>
+#include "hh_stl_iterator.h"
+#include "hh_stl_alloc.h"
+#include "hh_stl_uninitialized.h"
+#include "hh_stl_construct.h"
+#include "hh_config.h"
+
+namespace hh_std {
+
+// stable_vector keeps its elements in segments that double in size: segment k
+// holds B << k elements, where B is the first segment size.  Growth only adds
+// a segment, so elements are never moved and pointers and references stay
+// valid until the element is popped.  There are at most one segment per bit
+// of size_t, so the segment table is a fixed array in the container and is
+// never reallocated either.
+//
+// Element i lives in segment floor(log2(i / B + 1)), which is one bit scan.
+// Iterators keep a pointer into the segment table, so moving or swapping the
+// container invalidates iterators (not pointers or references).
+
+inline size_t __stable_floor_log2(size_t n) {
+#if defined(__GNUC__)
+    return sizeof(size_t) * 8 - 1 - __builtin_clzl(n);
+#else
+    size_t k = 0;
+    while(n >>= 1) {
+        ++k;
+    }
+    return k;
+#endif
+}
+
+// BufSize is the first segment size in elements, rounded up to a power of
+// two; 0 picks one so that the first segment is about 512 bytes, like deque.
+inline size_t stable_vector_shift(size_t buf_size, size_t sz) {
+    size_t n = buf_size == 0 ? (sz > 512 ? 1 : 512 / sz) : buf_size;
+    size_t shift = __stable_floor_log2(n);
+    return (size_t(1) << shift) < n ? shift + 1 : shift;
+}
+
+template <class T, size_t BufSize>
+struct __stable_vector_layout {
+    enum { max_segments = sizeof(size_t) * 8 };
+
+    static size_t shift() {
+        return stable_vector_shift(BufSize, sizeof(T));
+    }
+    static size_t segment_of(size_t i) {
+        return __stable_floor_log2((i >> shift()) + 1);
+    }
+    static size_t segment_start(size_t k) {
+        return ((size_t(1) << k) - 1) << shift();
+    }
+    static size_t segment_size(size_t k) {
+        return size_t(1) << (k + shift());
+    }
+};
+
+template <class T, class Ref, class Ptr, size_t BufSize>
+struct __stable_vector_iterator {
+    typedef __stable_vector_iterator<T, T&, T*, BufSize> iterator;
+    typedef __stable_vector_iterator<T, const T&, const T*, BufSize> const_iterator;
+    typedef __stable_vector_iterator self;
+    typedef __stable_vector_layout<T, BufSize> layout;
+
+    typedef random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T* const* map_pointer;
+
+    T* cur;
+    T* first;
+    T* last;
+    map_pointer map;
+    size_type index;
+
+    __stable_vector_iterator(map_pointer m, size_type i): map(m), index(i) {
+        locate();
+    }
+    __stable_vector_iterator(): cur(0), first(0), last(0), map(0), index(0) {}
+    __stable_vector_iterator(const iterator &x): cur(x.cur), first(x.first), last(x.last), map(x.map), index(x.index) {}
+
+    // Points cur at element index.  The slot one past the last segment has no
+    // storage; cur is left null there and only index is meaningful.
+    void locate() {
+        size_type k = layout::segment_of(index);
+        if(map[k]) {
+            first = map[k];
+            cur = first + (index - layout::segment_start(k));
+            last = first + layout::segment_size(k);
+        } else {
+            cur = first = last = 0;
+        }
+    }
+
+    reference operator* () const {
+        return *cur;
+    }
+    pointer operator-> () const {
+        return &(operator*());
+    }
+    difference_type operator- (const self &x) const {
+        return difference_type(index) - difference_type(x.index);
+    }
+    self &operator++ () {
+        ++index;
+        if(++cur == last) {
+            locate();
+        }
+        return *this;
+    }
+    self operator++ (int) {
+        self tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+    self &operator-- () {
+        --index;
+        if(cur == first) {
+            locate();
+        } else {
+            --cur;
+        }
+        return *this;
+    }
+    self operator-- (int) {
+        self tmp = *this;
+        --(*this);
+        return tmp;
+    }
+    self &operator+= (difference_type n) {
+        index += n;
+        locate();
+        return *this;
+    }
+    self &operator-= (difference_type n) {
+        return operator+=(-n);
+    }
+    self operator+ (difference_type n) const {
+        self tmp = *this;
+        tmp += n;
+        return tmp;
+    }
+    self operator- (difference_type n) const {
+        self tmp = *this;
+        tmp -= n;
+        return tmp;
+    }
+    reference operator[] (difference_type n) const {
+        return *(*this + n);
+    }
+    bool operator== (const self &x) const {
+        return index == x.index;
+    }
+    bool operator!= (const self &x) const {
+        return index != x.index;
+    }
+    bool operator< (const self &x) const {
+        return index < x.index;
+    }
+    bool operator> (const self &x) const {
+        return index > x.index;
+    }
+    bool operator<= (const self &x) const {
+        return index <= x.index;
+    }
+    bool operator>= (const self &x) const {
+        return index >= x.index;
+    }
+};
+
+template <class T, class Alloc = alloc, size_t BufSize = 0>
+class stable_vector: private __alloc_holder<Alloc> {
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+    typedef __stable_vector_iterator<T, T&, T*, BufSize> iterator;
+    typedef __stable_vector_iterator<T, const T&, const T*, BufSize> const_iterator;
+    typedef reverse_iterator<const_iterator> const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef simple_alloc<value_type, Alloc> data_allocator;
+    typedef __stable_vector_layout<T, BufSize> layout;
+
+    pointer map[layout::max_segments];
+    size_type nsegs;
+    size_type len;
+    // Where the next push_back goes, and the end of its segment.
+    pointer finish;
+    pointer finish_last;
+
+    void reset() {
+        for(size_type k = 0; k < size_type(layout::max_segments); k++) {
+            map[k] = 0;
+        }
+        nsegs = len = 0;
+        finish = finish_last = 0;
+    }
+    void set_finish() {
+        size_type k = layout::segment_of(len);
+        if(k < nsegs) {
+            finish = map[k] + (len - layout::segment_start(k));
+            finish_last = map[k] + layout::segment_size(k);
+        } else {
+            // len == capacity(): park at the end of the last segment, the
+            // next push_back adds a segment.
+            finish = finish_last = nsegs == 0 ? 0 : map[nsegs - 1] + layout::segment_size(nsegs - 1);
+        }
+    }
+    void add_segment() {
+        map[nsegs] = data_allocator::allocate(this->get_alloc(), layout::segment_size(nsegs));
+        ++nsegs;
+    }
+    // Called when finish has reached the end of its segment.
+    void next_segment() {
+        size_type k = layout::segment_of(len);
+        if(k == nsegs) {
+            add_segment();
+        }
+        finish = map[k];
+        finish_last = map[k] + layout::segment_size(k);
+    }
+    void release_segments(size_type keep) {
+        while(nsegs > keep) {
+            --nsegs;
+            data_allocator::deallocate(this->get_alloc(), map[nsegs], layout::segment_size(nsegs));
+            map[nsegs] = 0;
+        }
+    }
+    void steal(stable_vector &x) {
+        for(size_type k = 0; k < size_type(layout::max_segments); k++) {
+            map[k] = x.map[k];
+        }
+        nsegs = x.nsegs;
+        len = x.len;
+        finish = x.finish;
+        finish_last = x.finish_last;
+        x.reset();
+    }
+
+    void copy_assign_alloc(const stable_vector &x, __true_type) {
+        clear();
+        release_segments(0);
+        set_finish();
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const stable_vector&, __false_type) {
+    }
+    void move_assign(stable_vector &x, __true_type) {
+        clear();
+        release_segments(0);
+        this->get_alloc() = x.get_alloc();
+        steal(x);
+    }
+    // The allocator stays put, so the elements have to be moved one by one.
+    void move_assign(stable_vector &x, __false_type) {
+        clear();
+        for(iterator it = x.begin(); it != x.end(); ++it) {
+            push_back(std::move(*it));
+        }
+        x.clear();
+    }
+public:
+    stable_vector() {
+        reset();
+    }
+    explicit stable_vector(const allocator_type &a): alloc_base(a) {
+        reset();
+    }
+    stable_vector(size_type n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset();
+        resize(n, value);
+    }
+    stable_vector(int n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset();
+        resize(n, value);
+    }
+    stable_vector(long n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset();
+        resize(n, value);
+    }
+    explicit stable_vector(size_type n) {
+        reset();
+        resize(n);
+    }
+    template <class InputIterator>
+    stable_vector(InputIterator first, InputIterator last, const allocator_type &a = allocator_type()): alloc_base(a) {
+        reset();
+        __STL_TRY {
+            for(; first != last; ++first) {
+                push_back(*first);
+            }
+        }
+        __STL_UNWIND((clear(), release_segments(0)));
+    }
+    stable_vector(const stable_vector &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())) {
+        reset();
+        reserve(x.size());
+        __STL_TRY {
+            for(const_iterator it = x.begin(); it != x.end(); ++it) {
+                push_back(*it);
+            }
+        }
+        __STL_UNWIND((clear(), release_segments(0)));
+    }
+    stable_vector(stable_vector &&x): alloc_base(x.get_alloc()) {
+        reset();
+        steal(x);
+    }
+    stable_vector &operator= (const stable_vector &x) {
+        if(&x != this) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            clear();
+            reserve(x.size());
+            for(const_iterator it = x.begin(); it != x.end(); ++it) {
+                push_back(*it);
+            }
+        }
+        return *this;
+    }
+    stable_vector &operator= (stable_vector &&x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+    ~stable_vector() {
+        clear();
+        release_segments(0);
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    iterator begin() {
+        return iterator(map, 0);
+    }
+    const_iterator begin() const {
+        return const_iterator(map, 0);
+    }
+    iterator end() {
+        return iterator(map, len);
+    }
+    const_iterator end() const {
+        return const_iterator(map, len);
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    size_type size() const {
+        return len;
+    }
+    size_type max_size() const {
+        return size_type(-1) / sizeof(T);
+    }
+    size_type capacity() const {
+        return layout::segment_start(nsegs);
+    }
+    bool empty() const {
+        return len == 0;
+    }
+    reference operator[] (size_type n) {
+        size_type k = layout::segment_of(n);
+        return map[k][n - layout::segment_start(k)];
+    }
+    const_reference operator[] (size_type n) const {
+        size_type k = layout::segment_of(n);
+        return map[k][n - layout::segment_start(k)];
+    }
+    reference at(size_type n) {
+        return (*this)[n];
+    }
+    const_reference at(size_type n) const {
+        return (*this)[n];
+    }
+    reference front() {
+        return *map[0];
+    }
+    const_reference front() const {
+        return *map[0];
+    }
+    // finish may already sit at the start of the next segment (after reserve
+    // or pop_back on a segment boundary), so go through the index.
+    reference back() {
+        return (*this)[len - 1];
+    }
+    const_reference back() const {
+        return (*this)[len - 1];
+    }
+
+    void reserve(size_type n) {
+        while(capacity() < n) {
+            add_segment();
+        }
+        set_finish();
+    }
+    void push_back(const T &x) {
+        emplace_back(x);
+    }
+    void push_back(T &&x) {
+        emplace_back(std::move(x));
+    }
+    // Earlier elements never move, so args may refer into *this.
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        if(finish == finish_last) {
+            next_segment();
+        }
+        construct(finish, std::forward<Args>(args)...);
+        ++finish;
+        ++len;
+    }
+    void pop_back() {
+        --len;
+        set_finish();
+        destory(finish);
+    }
+    void resize(size_type new_size, const T &x) {
+        while(len > new_size) {
+            pop_back();
+        }
+        reserve(new_size);
+        while(len < new_size) {
+            push_back(x);
+        }
+    }
+    void resize(size_type new_size) {
+        resize(new_size, T());
+    }
+    // Destroys the elements but keeps the segments for reuse.
+    void clear() {
+        for(size_type k = 0; k < nsegs && layout::segment_start(k) < len; k++) {
+            size_type n = len - layout::segment_start(k);
+            if(n > layout::segment_size(k)) {
+                n = layout::segment_size(k);
+            }
+            destory(map[k], map[k] + n);
+        }
+        len = 0;
+        set_finish();
+    }
+    // Frees the segments that hold no elements.
+    void shrink_to_fit() {
+        release_segments(len == 0 ? 0 : layout::segment_of(len - 1) + 1);
+        set_finish();
+    }
+    void swap(stable_vector &x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        for(size_type k = 0; k < size_type(layout::max_segments); k++) {
+            std::swap(map[k], x.map[k]);
+        }
+        std::swap(nsegs, x.nsegs);
+        std::swap(len, x.len);
+        std::swap(finish, x.finish);
+        std::swap(finish_last, x.finish_last);
+    }
+};
+
+template <class T, class Alloc, size_t BufSize>
+inline bool operator== (const stable_vector<T, Alloc, BufSize> &a, const stable_vector<T, Alloc, BufSize> &b) {
+    if(a.size() != b.size()) {
+        return false;
+    }
+    typename stable_vector<T, Alloc, BufSize>::const_iterator x = a.begin(), y = b.begin();
+    for(; x != a.end(); ++x, ++y) {
+        if(!(*x == *y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T, class Alloc, size_t BufSize>
+inline bool operator!= (const stable_vector<T, Alloc, BufSize> &a, const stable_vector<T, Alloc, BufSize> &b) {
+    return !(a == b);
+}
+
+template <class T, class Alloc, size_t BufSize>
+inline void swap(stable_vector<T, Alloc, BufSize> &a, stable_vector<T, Alloc, BufSize> &b) {
+    a.swap(b);
+}
+
+};
+
+#endif
@@ -28,6 +28,11 @@ public:
 protected:
     Sequence c;
 public:
+    stack(): c() {}
+    // Adopts an already configured container (such as a circular_buffer of
+    // a given capacity) as the underlying sequence.
+    explicit stack(const Sequence &s): c(s) {}
+    explicit stack(Sequence &&s): c(std::move(s)) {}
     size_type size() const {
         return c.size();
     }
@@ -43,8 +48,18 @@ public:
     void pop() {
         c.pop_back();
     }
-    void push(const value_type &x) {
-        c.push_back(x);
+    // push and emplace return whatever the sequence returns: void for deque
+    // or vector, and for circular_buffer the bool that says whether the
+    // element was taken.
+    auto push(const value_type &x) -> decltype(c.push_back(x)) {
+        return c.push_back(x);
+    }
+    auto push(value_type &&x) -> decltype(c.push_back(std::move(x))) {
+        return c.push_back(std::move(x));
+    }
+    template <class... Args>
+    auto emplace(Args&&... args) -> decltype(c.emplace_back(std::forward<Args>(args)...)) {
+        return c.emplace_back(std::forward<Args>(args)...);
     }
     //template <class T1, class Sequence1>
     friend bool operator== <> (const stack &x, const stack &y);
@@ -8,6 +8,7 @@
 #include "hh_stl_pair.h"
 #include<cstddef>
 #include<algorithm>
+#include<utility>
 
 namespace hh_std {
 
@@ -337,11 +338,12 @@ inline __rb_tree_node_base *__rb_tree_rebalance_erase(__rb_tree_node_base *node,
 }
 
 template <class Value, class Key, class KeyofValue, class Compare, class Alloc = alloc>
-class rb_tree {
+class rb_tree: private __alloc_holder<Alloc> {
 protected:
     typedef __rb_tree_node_base* base_ptr;
     typedef __rb_tree_node<Value> rb_tree_node;
     typedef __rb_tree_node_color color_type;
+    typedef __alloc_holder<Alloc> alloc_base;
     typedef simple_alloc<rb_tree_node, Alloc> data_allocate;
 public:
     typedef Value value_type;
@@ -353,26 +355,26 @@ public:
     typedef rb_tree_node* link_type;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 protected:
     link_type get_node() {
-        return data_allocate::allocate();
+        return data_allocate::allocate(this->get_alloc());
     }
     void put_node(link_type x) {
-        data_allocate::deallocate(x);
+        data_allocate::deallocate(this->get_alloc(), x);
     }
-    link_type create_node(const value_type &x) {
-        link_type result;
+    template <class... Args>
+    link_type create_node(Args&&... args) {
+        link_type result = get_node();
         __STL_TRY {
-            result = get_node();
-            construct(&(result->data), x);
+            construct(&(result->data), std::forward<Args>(args)...);
         }
-        __STL_UNWIND(destory(result));
+        __STL_UNWIND(put_node(result));
         result->parent = result->left = result->right = 0;
         return result;
     }
     link_type clone_node(const link_type x) {
-        link_type tmp = get_node();
-        tmp->data = x->data;
+        link_type tmp = create_node(x->data);
         tmp->color = x->color;
         tmp->parent = tmp->left = tmp->right = 0;
         return tmp;
@@ -454,9 +456,12 @@ private:
         parent(header) = 0;
         leftmost() = rightmost() = header;
     }
-    iterator __insert(base_ptr x, base_ptr y, const value_type &v) {
-        link_type x_ = link_type(x), y_ = link_type(y), z = create_node(v);
-        if(y == header || x_ != 0 || comp(KeyofValue()(v), key(y))) {
+    template <class V>
+    iterator __insert(base_ptr x, base_ptr y, V &&v) {
+        return __link_node(x, y, create_node(std::forward<V>(v)));
+    }
+    iterator __link_node(base_ptr x, base_ptr y, link_type z) {
+        if(y == header || x != 0 || comp(key(z), key(y))) {
             left(y) = z;
             if(y == leftmost()) {
                 leftmost() = z;
@@ -476,6 +481,115 @@ private:
         ++node_count;
         return iterator(z);
     }
+    // Returns the node equal to k, or 0 with p set to the parent k would hang from.
+    link_type __unique_parent(const key_type &k, link_type &p) {
+        link_type cur = root();
+        p = header;
+        while(cur) {
+            p = cur;
+            if(comp(k, key(cur))) {
+                cur = (link_type)cur->left;
+            } else {
+                if(!comp(key(cur), k)) {
+                    return cur;
+                }
+                cur = (link_type)cur->right;
+            }
+        }
+        return 0;
+    }
+    link_type __equal_parent(const key_type &k) {
+        link_type cur = root(), p = header;
+        while(cur) {
+            p = cur;
+            if(comp(k, key(cur))) {
+                cur = (link_type)cur->left;
+            } else {
+                cur = (link_type)cur->right;
+            }
+        }
+        return p;
+    }
+    // Whether k can go right before pos; on success x and y are the __link_node arguments.
+    bool __unique_hint(iterator pos, const key_type &k, base_ptr &x, base_ptr &y) {
+        if(pos.node == header->left) {
+            if(size() > 0 && comp(k, key(pos.node))) {
+                x = y = pos.node;
+                return true;
+            }
+        } else if(pos.node == header) {
+            if(comp(key(header->right), k)) {
+                x = 0;
+                y = header->right;
+                return true;
+            }
+        } else {
+            iterator before = pos;
+            --before;
+            if(comp(key(before.node), k) && comp(k, key(pos.node))) {
+                if(right(before.node) == 0) {
+                    x = 0;
+                    y = before.node;
+                } else {
+                    x = y = pos.node;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+    bool __equal_hint(iterator pos, const key_type &k, base_ptr &x, base_ptr &y) {
+        if(pos.node == header->left) {
+            if(size() > 0 && !comp(key(pos.node), k)) {
+                x = y = pos.node;
+                return true;
+            }
+        } else if(pos.node == header) {
+            if(!comp(k, key(header->right))) {
+                x = 0;
+                y = header->right;
+                return true;
+            }
+        } else {
+            iterator before = pos;
+            --before;
+            if(!comp(k, key(before.node)) && !comp(key(pos.node), k)) {
+                if(right(before.node) == 0) {
+                    x = 0;
+                    y = before.node;
+                } else {
+                    x = y = pos.node;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+    template <class V>
+    hh_std::pair<iterator, bool> __insert_unique(V &&v) {
+        link_type p;
+        link_type cur = __unique_parent(KeyofValue()(v), p);
+        if(cur) {
+            return hh_std::pair<iterator, bool>(iterator(cur), false);
+        }
+        return hh_std::pair<iterator, bool>(__insert(0, p, std::forward<V>(v)), true);
+    }
+    template <class V>
+    iterator __insert_unique(iterator pos, V &&v) {
+        base_ptr x, y;
+        if(__unique_hint(pos, KeyofValue()(v), x, y)) {
+            return __insert(x, y, std::forward<V>(v));
+        }
+        return __insert_unique(std::forward<V>(v)).first;
+    }
+    template <class V>
+    iterator __insert_equal(iterator pos, V &&v) {
+        base_ptr x, y;
+        if(__equal_hint(pos, KeyofValue()(v), x, y)) {
+            return __insert(x, y, std::forward<V>(v));
+        }
+        return __insert(0, __equal_parent(KeyofValue()(v)), std::forward<V>(v));
+    }
     link_type __copy(link_type x, link_type p) {
         link_type cur = clone_node(x);
         cur->parent = p;
@@ -515,24 +629,42 @@ private:
             x = y;
         }
     }
-    void __assign_recur(link_type x, link_type y, link_type p) {
-        if(x == 0 && y == 0) return;
-        if(x != 0 && y != 0) {
-            x->data = y->data;
-            x->color = y->color;
-            __assign_recur((link_type)x->left, (link_type)y->left, x);
-            __assign_recur((link_type)x->right, (link_type)y->right, x);
-        } else if(x == 0 && y != 0) {
-            x = __copy((link_type)y, p);
-        } else {
-            __erase(x);
+    void copy_assign_alloc(const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x, __true_type) {
+        clear();
+        put_node(header);
+        this->get_alloc() = x.get_alloc();
+        init();
+    }
+    void copy_assign_alloc(const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &, __false_type) {
+    }
+    void swap_data(rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x) {
+        std::swap(header, x.header);
+        std::swap(node_count, x.node_count);
+        std::swap(comp, x.comp);
+    }
+    void move_assign(rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x, __true_type) {
+        clear();
+        swap_data(x);
+        __alloc_swap(this->get_alloc(), x.get_alloc(), __true_type());
+    }
+    void move_assign(rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x, __false_type) {
+        clear();
+        comp = x.comp;
+        for(iterator it = x.begin(); it != x.end(); ++it) {
+            __insert(0, header->right, std::move(*it));
         }
+        x.clear();
     }
 public:
     rb_tree(const Compare c = Compare()): node_count(0), comp(c) {
         init();
     }
-    rb_tree(const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x): node_count(0), comp(x.comp) {
+    rb_tree(const Compare &c, const allocator_type &a): alloc_base(a), node_count(0), comp(c) {
+        init();
+    }
+    rb_tree(const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())),
+        node_count(0), comp(x.comp) {
         header = get_node();
         header->color = red;
         __STL_TRY{
@@ -548,6 +680,11 @@ public:
         __STL_UNWIND(put_node(header));
         node_count = x.node_count;
     }
+    rb_tree(rb_tree<Value, Key, KeyofValue, Compare, Alloc> &&x):
+        alloc_base(x.get_alloc()), node_count(0), comp(x.comp) {
+        init();
+        swap_data(x);
+    }
     ~rb_tree() {
         clear();
         put_node(header);
@@ -562,10 +699,11 @@ public:
     }
     rb_tree<Value, Key, KeyofValue, Compare, Alloc> &operator= (const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x) {
         if(this != &x) {
-            if(x.root() == 0) {
-                clear();
-            } else {
-                __assign_recur(root(), x.root(), header);
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            clear();
+            comp = x.comp;
+            if(x.root() != 0) {
+                root() = __copy(x.root(), header);
                 leftmost() = (link_type)__rb_tree_node_base::minimum(root());
                 rightmost() = (link_type)__rb_tree_node_base::maxmum(root());
                 node_count = x.node_count;
@@ -573,9 +711,18 @@ public:
         }
         return *this;
     }
+    rb_tree<Value, Key, KeyofValue, Compare, Alloc> &operator= (rb_tree<Value, Key, KeyofValue, Compare, Alloc> &&x) {
+        if(this != &x) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
     Compare key_comp() const {
         return comp;
     }
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
     iterator begin() {
         return iterator(leftmost());
     }
@@ -610,82 +757,74 @@ public:
         return size_type(-1);
     }
     void swap(rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x) {
-        std::swap(header, x.header);
-        std::swap(node_count, x.node_count);
-        std::swap(comp, x.comp);
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        swap_data(x);
     }
     hh_std::pair<iterator, bool> insert_unique(const value_type &x) {
-        link_type cur = root(), p = header;
-        while(cur) {
-            p = cur;
-            if(comp(KeyofValue()(x), key(cur))) {
-                cur = (link_type)cur->left;
-            } else {
-                if(!comp(key(cur), KeyofValue()(x))) {
-                    return hh_std::pair<iterator, bool>(iterator(cur), false);
-                }
-                cur = (link_type)cur->right;
-            }
-        }
-        return hh_std::pair<iterator, bool>(__insert(cur, p, x), true);
+        return __insert_unique(x);
+    }
+    hh_std::pair<iterator, bool> insert_unique(value_type &&x) {
+        return __insert_unique(std::move(x));
     }
     iterator insert_equal(const value_type &x) {
-        link_type cur = root(), p = header;
-        while(cur) {
-            p = cur;
-            if(comp(KeyofValue()(x), key(cur))) {
-                cur = (link_type)cur->left;
-            } else {
-                cur = (link_type)cur->right;
-            }
-        }
-        return __insert(cur, p, x);
+        return __insert(0, __equal_parent(KeyofValue()(x)), x);
+    }
+    iterator insert_equal(value_type &&x) {
+        return __insert(0, __equal_parent(KeyofValue()(x)), std::move(x));
     }
     iterator insert_unique(iterator pos, const value_type &x) {
-        if(pos.node == header->left) {
-            if(size() > 0 && comp(KeyofValue()(x), key(pos.node))) {
-                return __insert(pos.node, pos.node, x);
-            }
-            return insert_unique(x).first;
-        } else if(pos.node == header) {
-            if(comp(key(header->right), KeyofValue()(x))) {
-                return __insert(0, pos.node, x);
-            }
-            return insert_unique(x).first;
-        } else {
-            iterator before = pos;
-            --before;
-            if(comp(key(before.node), KeyofValue()(x)) && comp(KeyofValue()(x), key(pos.node))) {
-                if(right(before) == 0) {
-                    return __insert(0, before.node, x);
-                }
-                return __insert(pos.node, pos.node, x);
-            }
-            return insert_unique(x).first;
-        }
+        return __insert_unique(pos, x);
+    }
+    iterator insert_unique(iterator pos, value_type &&x) {
+        return __insert_unique(pos, std::move(x));
     }
     iterator insert_equal(iterator pos, const value_type &x) {
-        if(pos.node == header->left) {
-            if(size() > 0 && comp(KeyofValue()(x), key(pos.node))) {
-                return __insert(pos.node, pos.node, x);
-            }
-            return insert_equal(x);
-        } else if(pos.node == header) {
-            if(!comp(KeyofValue()(x), key(header->right))) {
-                return __insert(0, pos.node, x);
-            }
-            return insert_equal(x).first;
-        } else {
-            iterator before = pos;
-            --before;
-            if(!comp(KeyofValue()(x), key(before.node)) && !comp(key(pos.node), KeyofValue()(x))) {
-                if(right(before) == 0) {
-                    return __insert(0, before.node, x);
-                }
-                return __insert(pos.node, pos.node, x);
-            }
-            return insert_equal(x).first;
+        return __insert_equal(pos, x);
+    }
+    iterator insert_equal(iterator pos, value_type &&x) {
+        return __insert_equal(pos, std::move(x));
+    }
+    // The emplace family builds the node before reading its key and destroys it on a duplicate.
+    template <class... Args>
+    hh_std::pair<iterator, bool> emplace_unique(Args&&... args) {
+        link_type z = create_node(std::forward<Args>(args)...);
+        link_type p;
+        link_type cur = __unique_parent(key(z), p);
+        if(cur) {
+            destory_node(z);
+            return hh_std::pair<iterator, bool>(iterator(cur), false);
+        }
+        return hh_std::pair<iterator, bool>(__link_node(0, p, z), true);
+    }
+    template <class... Args>
+    iterator emplace_equal(Args&&... args) {
+        link_type z = create_node(std::forward<Args>(args)...);
+        return __link_node(0, __equal_parent(key(z)), z);
+    }
+    template <class... Args>
+    iterator emplace_hint_unique(iterator pos, Args&&... args) {
+        link_type z = create_node(std::forward<Args>(args)...);
+        base_ptr x, y;
+        if(__unique_hint(pos, key(z), x, y)) {
+            return __link_node(x, y, z);
+        }
+        link_type p;
+        link_type cur = __unique_parent(key(z), p);
+        if(cur) {
+            destory_node(z);
+            return iterator(cur);
+        }
+        return __link_node(0, p, z);
+    }
+    template <class... Args>
+    iterator emplace_hint_equal(iterator pos, Args&&... args) {
+        link_type z = create_node(std::forward<Args>(args)...);
+        base_ptr x, y;
+        if(__equal_hint(pos, key(z), x, y)) {
+            return __link_node(x, y, z);
         }
+        return __link_node(0, __equal_parent(key(z)), z);
     }
     template <class InputIterator>
     void insert_unique(InputIterator first, InputIterator last) {
@@ -710,7 +849,7 @@ public:
     }
     size_type erase(const key_type & x) {
         hh_std::pair<iterator, iterator> range = equal_range(x);
-        size_type result = distance(range.first, range.second);
+        size_type result = hh_std::distance(range.first, range.second);
         erase(range.first, range.second);
         return result;
     }
@@ -739,9 +878,9 @@ public:
                 if(!comp(x, key(cur))) {
                     seleted = cur;
                 }
-                cur = cur->left;
+                cur = left(cur);
             } else {
-                cur = cur->right;
+                cur = right(cur);
             }
         }
         return seleted == 0 ? end() : iterator(seleted);
@@ -753,16 +892,16 @@ public:
                 if(!comp(x, key(cur))) {
                     seleted = cur;
                 }
-                cur = cur->left;
+                cur = left(cur);
             } else {
-                cur = cur->right;
+                cur = right(cur);
             }
         }
         return seleted == 0 ? end() : const_iterator(seleted);
     }
     size_type count(const key_type & x) const {
         hh_std::pair<const_iterator, const_iterator> result = equal_range(x);
-        difference_type len = distance(result.first, result.second);
+        difference_type len = hh_std::distance(result.first, result.second);
         return len;
     }
     iterator lower_bound(const key_type & x) {
@@ -895,7 +1034,7 @@ inline bool operator< (const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x,
 }
 
 template <class Value, class Key, class KeyofValue, class Compare, class Alloc>
-inline void swap(const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x, const rb_tree<Value, Key, KeyofValue, Compare, Alloc> &y) {
+inline void swap(rb_tree<Value, Key, KeyofValue, Compare, Alloc> &x, rb_tree<Value, Key, KeyofValue, Compare, Alloc> &y) {
     x.swap(y);
 }
 
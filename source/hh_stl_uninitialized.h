@@ -6,6 +6,7 @@
 #include "hh_stl_construct.h"
 #include<cstring>
 #include<algorithm>
+#include<utility>
 
 template <class InputIterator, class ForwardIterator>
 inline ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator dest, hh_std::__true_type) {
@@ -45,6 +46,66 @@ inline wchar_t *uninitialized_copy(wchar_t *first, wchar_t *last, wchar_t *dest)
     return dest + (last - first);
 }
 
+template <class InputIterator, class ForwardIterator>
+inline ForwardIterator __uninitialized_move_aux(InputIterator first, InputIterator last, ForwardIterator dest, hh_std::__true_type) {
+    return std::copy(first, last, dest);
+}
+
+template <class InputIterator, class ForwardIterator>
+inline ForwardIterator __uninitialized_move_aux(InputIterator first, InputIterator last, ForwardIterator dest, hh_std::__false_type) {
+    while(first != last) {
+        construct(&*dest, std::move(*first));
+        first++;
+        dest++;
+    }
+    return dest;
+}
+
+template <class InputIterator, class ForwardIterator, class T>
+inline ForwardIterator __uninitialized_move(InputIterator first, InputIterator last, ForwardIterator dest, T*) {
+    typedef typename hh_std::__type_traits<T>::is_POD_type type;
+    return __uninitialized_move_aux(first, last, dest, type());
+}
+
+// Like uninitialized_copy, but the source elements are left moved-from.
+template <class InputIterator, class ForwardIterator>
+inline ForwardIterator uninitialized_move(InputIterator first, InputIterator last, ForwardIterator dest) {
+    return __uninitialized_move(first, last, dest, hh_std::value_type(first));
+}
+
+template <class InputIterator, class ForwardIterator>
+inline ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, ForwardIterator dest, hh_std::__true_type) {
+    return std::copy(first, last, dest);
+}
+
+template <class InputIterator, class ForwardIterator>
+inline ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, ForwardIterator dest, hh_std::__false_type) {
+    ForwardIterator cur = dest;
+    try {
+        for(; first != last; ++first, ++cur) {
+            construct(&*cur, std::move_if_noexcept(*first));
+        }
+    } catch(...) {
+        destory(dest, cur);
+        throw;
+    }
+    return cur;
+}
+
+template <class InputIterator, class ForwardIterator, class T>
+inline ForwardIterator __uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator dest, T*) {
+    typedef typename hh_std::__type_traits<T>::is_POD_type type;
+    return __uninitialized_move_if_noexcept_aux(first, last, dest, type());
+}
+
+// Moves when T's move constructor cannot throw and copies otherwise, so a throw
+// leaves the source untouched; whatever was built in dest is destroyed again.
+// This is what reallocation needs for the strong guarantee.
+template <class InputIterator, class ForwardIterator>
+inline ForwardIterator uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator dest) {
+    return __uninitialized_move_if_noexcept(first, last, dest, hh_std::value_type(first));
+}
+
 template <class ForwardIterator, class T>
 inline void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, T &value, hh_std::__true_type) {
     std::fill(first, last, value);
@@ -91,7 +152,7 @@ inline void __uninitialized_fill_n(ForwardIterator first, Size n, T &value, T2 *
 
 template <class ForwardIterator, class Size, class T>
 inline void uninitialized_fill_n(ForwardIterator first, Size n, T &value) {
-    __uninitialized_fill_n(first, n, value, value_type(first));
+    __uninitialized_fill_n(first, n, value, hh_std::value_type(first));
 }
 
 #endif
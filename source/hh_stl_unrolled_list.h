@@ -0,0 +1,519 @@
+#ifndef __HH_STL_UNROLLED_LIST_H_
+#define __HH_STL_UNROLLED_LIST_H_
+
+#include<cstddef>
+#include<utility>
+#include<type_traits>
+#include<algorithm>
+#include "hh_stl_iterator.h"
+#include "hh_stl_alloc.h"
+#include "hh_stl_construct.h"
+#include "hh_config.h"
+
+namespace hh_std {
+
+// A doubly linked list of nodes that each hold up to N elements in a small
+// array, kept packed at the front.  Walking it touches one node per N
+// elements, and an insert or erase only shifts elements within one node:
+// a full node is split in half, and a node that drops below half full is
+// merged with its successor when they fit together.
+//
+// Inserting or erasing invalidates iterators into the nodes it touches (the
+// node, and on a split or merge its neighbour); other iterators stay valid.
+// The nodes are contiguous runs, so the segmented algorithms (copy, fill,
+// for_each, find, accumulate) walk them as raw pointer ranges.
+
+// N is the node capacity; 0 picks about 512 bytes of elements, at least 8.
+constexpr size_t unrolled_list_node_elems(size_t n, size_t sz) {
+    return n != 0 ? n : (sz < 64 ? 512 / sz : 8);
+}
+
+struct __unrolled_node_base {
+    __unrolled_node_base *prev;
+    __unrolled_node_base *next;
+    size_t count;
+};
+
+template <class T, size_t N>
+struct __unrolled_node: public __unrolled_node_base {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[N];
+};
+
+// The header is only a __unrolled_node_base; its data pointer is never
+// dereferenced, it only closes empty ranges.
+template <class T, size_t N>
+inline T *__unrolled_data(__unrolled_node_base *n) {
+    return reinterpret_cast<T*>(static_cast<__unrolled_node<T, N>*>(n)->slots);
+}
+
+template <class T, class Ref, class Ptr, size_t N>
+struct __unrolled_list_iterator {
+    typedef __unrolled_list_iterator<T, T&, T*, N> iterator;
+    typedef __unrolled_list_iterator<T, const T&, const T*, N> const_iterator;
+    typedef __unrolled_list_iterator self;
+
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    __unrolled_node_base *node;
+    size_type index;
+
+    __unrolled_list_iterator(__unrolled_node_base *n, size_type i): node(n), index(i) {}
+    __unrolled_list_iterator(): node(0), index(0) {}
+    __unrolled_list_iterator(const iterator &x): node(x.node), index(x.index) {}
+
+    reference operator* () const {
+        return __unrolled_data<T, N>(node)[index];
+    }
+    pointer operator-> () const {
+        return &(operator*());
+    }
+    self &operator++ () {
+        if(++index == node->count) {
+            node = node->next;
+            index = 0;
+        }
+        return *this;
+    }
+    self operator++ (int) {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self &operator-- () {
+        if(index == 0) {
+            node = node->prev;
+            index = node->count;
+        }
+        --index;
+        return *this;
+    }
+    self operator-- (int) {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+    bool operator== (const self &x) const {
+        return node == x.node && index == x.index;
+    }
+    bool operator!= (const self &x) const {
+        return !(*this == x);
+    }
+};
+
+template <class T, class Ref, class Ptr, size_t N>
+struct __segmented_iterator_traits<__unrolled_list_iterator<T, Ref, Ptr, N> > {
+    typedef __segmented_tag category;
+    typedef __unrolled_list_iterator<T, Ref, Ptr, N> iterator;
+    typedef Ptr local_iterator;
+
+    struct segment_iterator {
+        __unrolled_node_base *node;
+
+        explicit segment_iterator(__unrolled_node_base *n): node(n) {}
+        segment_iterator &operator++ () {
+            node = node->next;
+            return *this;
+        }
+        bool operator== (const segment_iterator &x) const {
+            return node == x.node;
+        }
+        bool operator!= (const segment_iterator &x) const {
+            return node != x.node;
+        }
+    };
+
+    static segment_iterator segment(const iterator &it) {
+        return segment_iterator(it.node);
+    }
+    static local_iterator local(const iterator &it) {
+        return begin(segment(it)) + it.index;
+    }
+    static local_iterator begin(segment_iterator s) {
+        return __unrolled_data<T, N>(s.node);
+    }
+    static local_iterator end(segment_iterator s) {
+        return begin(s) + s.node->count;
+    }
+    static iterator compose(segment_iterator s, local_iterator l) {
+        if(l == end(s)) {
+            return iterator(s.node->next, 0);
+        }
+        return iterator(s.node, l - begin(s));
+    }
+};
+
+template <class T, class Alloc = alloc, size_t K = 0>
+class unrolled_list: private __alloc_holder<Alloc> {
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+    static constexpr size_type node_elems() {
+        return unrolled_list_node_elems(K, sizeof(T));
+    }
+
+    typedef __unrolled_list_iterator<T, T&, T*, unrolled_list_node_elems(K, sizeof(T))> iterator;
+    typedef __unrolled_list_iterator<T, const T&, const T*, unrolled_list_node_elems(K, sizeof(T))> const_iterator;
+    typedef reverse_iterator<const_iterator> const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef __unrolled_node_base node_base;
+    typedef __unrolled_node<T, unrolled_list_node_elems(K, sizeof(T))> node_type;
+    typedef simple_alloc<node_type, Alloc> node_allocator;
+
+    // Circular, closed by a header that holds no elements.
+    node_base header;
+    size_type len;
+
+    static T *data(node_base *n) {
+        return __unrolled_data<T, unrolled_list_node_elems(K, sizeof(T))>(n);
+    }
+    void empty_initialize() {
+        header.prev = header.next = &header;
+        header.count = 0;
+        len = 0;
+    }
+    node_base *create_node_after(node_base *pos) {
+        node_base *n = node_allocator::allocate(this->get_alloc());
+        n->count = 0;
+        n->prev = pos;
+        n->next = pos->next;
+        pos->next->prev = n;
+        pos->next = n;
+        return n;
+    }
+    void free_node(node_base *n) {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+        node_allocator::deallocate(this->get_alloc(), static_cast<node_type*>(n));
+    }
+    // Moves d[from, count) of n to the end of m, which must have room.
+    static void move_tail(node_base *n, size_type from, node_base *m) {
+        T *src = data(n), *dst = data(m) + m->count;
+        for(size_type j = from; j < n->count; j++) {
+            construct(dst++, std::move(src[j]));
+            destory(src + j);
+        }
+        m->count += n->count - from;
+        n->count = from;
+    }
+    // Opens slot i of n (which has room) and moves x into it.
+    static void insert_into(node_base *n, size_type i, T &x) {
+        T *d = data(n);
+        if(i == n->count) {
+            construct(d + i, std::move(x));
+        } else {
+            construct(d + n->count, std::move(d[n->count - 1]));
+            std::move_backward(d + i, d + n->count - 1, d + n->count);
+            d[i] = std::move(x);
+        }
+        ++n->count;
+    }
+    void steal(unrolled_list &x) {
+        if(x.empty()) {
+            empty_initialize();
+        } else {
+            header = x.header;
+            len = x.len;
+            header.next->prev = &header;
+            header.prev->next = &header;
+            x.empty_initialize();
+        }
+    }
+
+    void copy_assign_alloc(const unrolled_list &x, __true_type) {
+        clear();
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const unrolled_list&, __false_type) {
+    }
+    void move_assign(unrolled_list &x, __true_type) {
+        clear();
+        this->get_alloc() = x.get_alloc();
+        steal(x);
+    }
+    // The allocator stays put, so the elements have to be moved one by one.
+    void move_assign(unrolled_list &x, __false_type) {
+        clear();
+        for(iterator it = x.begin(); it != x.end(); ++it) {
+            push_back(std::move(*it));
+        }
+        x.clear();
+    }
+public:
+    unrolled_list() {
+        empty_initialize();
+    }
+    explicit unrolled_list(const allocator_type &a): alloc_base(a) {
+        empty_initialize();
+    }
+    unrolled_list(size_type n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        empty_initialize();
+        resize(n, value);
+    }
+    unrolled_list(int n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        empty_initialize();
+        resize(n, value);
+    }
+    unrolled_list(long n, const T &value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        empty_initialize();
+        resize(n, value);
+    }
+    explicit unrolled_list(size_type n) {
+        empty_initialize();
+        resize(n);
+    }
+    template <class InputIterator>
+    unrolled_list(InputIterator first, InputIterator last, const allocator_type &a = allocator_type()): alloc_base(a) {
+        empty_initialize();
+        __STL_TRY {
+            for(; first != last; ++first) {
+                push_back(*first);
+            }
+        }
+        __STL_UNWIND(clear());
+    }
+    unrolled_list(const unrolled_list &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())) {
+        empty_initialize();
+        __STL_TRY {
+            for(const_iterator it = x.begin(); it != x.end(); ++it) {
+                push_back(*it);
+            }
+        }
+        __STL_UNWIND(clear());
+    }
+    unrolled_list(unrolled_list &&x): alloc_base(x.get_alloc()) {
+        steal(x);
+    }
+    unrolled_list &operator= (const unrolled_list &x) {
+        if(&x != this) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            clear();
+            for(const_iterator it = x.begin(); it != x.end(); ++it) {
+                push_back(*it);
+            }
+        }
+        return *this;
+    }
+    unrolled_list &operator= (unrolled_list &&x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+    ~unrolled_list() {
+        clear();
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    iterator begin() {
+        return iterator(header.next, 0);
+    }
+    const_iterator begin() const {
+        return const_iterator(iterator(header.next, 0));
+    }
+    iterator end() {
+        return iterator(&header, 0);
+    }
+    const_iterator end() const {
+        return const_iterator(iterator(const_cast<node_base*>(&header), 0));
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    size_type size() const {
+        return len;
+    }
+    size_type max_size() const {
+        return size_type(-1) / sizeof(T);
+    }
+    bool empty() const {
+        return len == 0;
+    }
+    reference front() {
+        return data(header.next)[0];
+    }
+    const_reference front() const {
+        return data(header.next)[0];
+    }
+    reference back() {
+        return data(header.prev)[header.prev->count - 1];
+    }
+    const_reference back() const {
+        return data(header.prev)[header.prev->count - 1];
+    }
+
+    // args may refer into *this: the element is built before anything moves.
+    template <class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
+        T x(std::forward<Args>(args)...);
+        node_base *n = pos.node;
+        size_type i = pos.index;
+        if(n == &header || (i == 0 && n->count == node_elems() && n->prev != &header && n->prev->count < node_elems())) {
+            // Before end(), or at the front of a full node whose predecessor
+            // has room: append to the predecessor instead of splitting.
+            n = n->prev;
+            if(n == &header || n->count == node_elems()) {
+                n = create_node_after(n);
+            }
+            i = n->count;
+        } else if(n->count == node_elems()) {
+            node_base *m = create_node_after(n);
+            size_type half = node_elems() / 2;
+            move_tail(n, half, m);
+            if(i > half) {
+                n = m;
+                i -= half;
+            }
+        }
+        insert_into(n, i, x);
+        ++len;
+        return iterator(n, i);
+    }
+    iterator insert(iterator pos, const T &x) {
+        return emplace(pos, x);
+    }
+    iterator insert(iterator pos, T &&x) {
+        return emplace(pos, std::move(x));
+    }
+    void push_back(const T &x) {
+        emplace(end(), x);
+    }
+    void push_back(T &&x) {
+        emplace(end(), std::move(x));
+    }
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        emplace(end(), std::forward<Args>(args)...);
+    }
+    void push_front(const T &x) {
+        emplace(begin(), x);
+    }
+    void push_front(T &&x) {
+        emplace(begin(), std::move(x));
+    }
+    template <class... Args>
+    void emplace_front(Args&&... args) {
+        emplace(begin(), std::forward<Args>(args)...);
+    }
+    iterator erase(iterator pos) {
+        node_base *n = pos.node;
+        size_type i = pos.index;
+        T *d = data(n);
+        std::move(d + i + 1, d + n->count, d + i);
+        destory(d + n->count - 1);
+        --n->count;
+        --len;
+        if(n->count == 0) {
+            node_base *next = n->next;
+            free_node(n);
+            return iterator(next, 0);
+        }
+        node_base *next = n->next;
+        if(n->count < node_elems() / 2 && next != &header && n->count + next->count <= node_elems()) {
+            move_tail(next, 0, n);
+            free_node(next);
+        }
+        if(i < n->count) {
+            return iterator(n, i);
+        }
+        return iterator(n->next, 0);
+    }
+    // A merge may move the elements of last, so erase by count.
+    iterator erase(iterator first, iterator last) {
+        size_type n = hh_std::distance(first, last);
+        while(n--) {
+            first = erase(first);
+        }
+        return first;
+    }
+    void pop_back() {
+        erase(iterator(header.prev, header.prev->count - 1));
+    }
+    void pop_front() {
+        erase(begin());
+    }
+    void resize(size_type new_size, const T &x) {
+        while(len > new_size) {
+            pop_back();
+        }
+        while(len < new_size) {
+            push_back(x);
+        }
+    }
+    void resize(size_type new_size) {
+        resize(new_size, T());
+    }
+    void clear() {
+        while(header.next != &header) {
+            node_base *n = header.next;
+            destory(data(n), data(n) + n->count);
+            free_node(n);
+        }
+        len = 0;
+    }
+    void swap(unrolled_list &x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        unrolled_list tmp(std::move(x));
+        x.steal(*this);
+        steal(tmp);
+    }
+};
+
+template <class T, class Alloc, size_t K>
+inline bool operator== (const unrolled_list<T, Alloc, K> &a, const unrolled_list<T, Alloc, K> &b) {
+    if(a.size() != b.size()) {
+        return false;
+    }
+    typename unrolled_list<T, Alloc, K>::const_iterator x = a.begin(), y = b.begin();
+    for(; x != a.end(); ++x, ++y) {
+        if(!(*x == *y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T, class Alloc, size_t K>
+inline bool operator!= (const unrolled_list<T, Alloc, K> &a, const unrolled_list<T, Alloc, K> &b) {
+    return !(a == b);
+}
+
+template <class T, class Alloc, size_t K>
+inline bool operator< (const unrolled_list<T, Alloc, K> &a, const unrolled_list<T, Alloc, K> &b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <class T, class Alloc, size_t K>
+inline void swap(unrolled_list<T, Alloc, K> &a, unrolled_list<T, Alloc, K> &b) {
+    a.swap(b);
+}
+
+};
+
+#endif
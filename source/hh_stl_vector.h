@@ -3,6 +3,9 @@
 
 #include<cstddef>
 #include<algorithm>
+#include<utility>
+#include<cstring>
+#include<type_traits>
 #include "hh_stl_iterator.h"
 #include "hh_stl_alloc.h"
 #include "hh_stl_uninitialized.h"
@@ -10,7 +13,7 @@
 namespace hh_std {
 
 template <class T, class Alloc = alloc>  // jjhou: alloc defined in stl_alloc.h
-class vector {
+class vector: private __alloc_holder<Alloc> {
 public:
     typedef T value_type;
     typedef value_type* pointer;
@@ -21,26 +24,121 @@ public:
     typedef const value_type& const_reference;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 
     typedef reverse_iterator<const_iterator>  const_r_iterator;
     typedef reverse_iterator<iterator> r_iterator;
 protected:
+    typedef __alloc_holder<Alloc> alloc_base;
     typedef simple_alloc<value_type, Alloc> data_allocator;
+    typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+    typedef typename __alloc_traits<Alloc>::has_reallocate can_reallocate;
     iterator start;
     iterator finish;
     iterator end_of_storage;
-    void insert_aux(iterator position, const T& x);
+    template <class... Args>
+    void insert_aux(iterator position, Args&&... args);
+    template <class... Args>
+    void realloc_insert(iterator position, __true_type, Args&&... args);
+    template <class... Args>
+    void realloc_insert(iterator position, __false_type, Args&&... args);
     void deallocate() {
         if(start) {
-            data_allocator::deallocate(start, (end_of_storage - start));
+            data_allocator::deallocate(this->get_alloc(), start, (end_of_storage - start));
         }
     }
 
+    void copy_assign_alloc(const vector<T, Alloc>& x, __true_type) {
+        destory(start, finish);
+        deallocate();
+        start = finish = end_of_storage = 0;
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const vector<T, Alloc>&, __false_type) {
+    }
+
+    void move_assign(vector<T, Alloc>& x, __true_type) {
+        destory(start, finish);
+        deallocate();
+        this->get_alloc() = x.get_alloc();
+        start = x.start;
+        finish = x.finish;
+        end_of_storage = x.end_of_storage;
+        x.start = x.finish = x.end_of_storage = 0;
+    }
+    // The allocator stays put, so the elements have to be moved one by one.
+    void move_assign(vector<T, Alloc>& x, __false_type) {
+        clear();
+        if(x.size() > capacity()) {
+            deallocate();
+            start = finish = end_of_storage = 0;
+            start = data_allocator::allocate(this->get_alloc(), x.size());
+            finish = start;
+            end_of_storage = start + x.size();
+        }
+        finish = uninitialized_move(x.start, x.finish, start);
+        x.clear();
+    }
+
+    // Moves the elements into a block of new_capacity with n raw slots
+    // opened at pos and returns the first slot.  Only for trivially
+    // relocatable T: the elements travel as bytes and the old ones are
+    // never destroyed, so nothing after the allocation can throw.
+    iterator relocate_with_gap(iterator pos, size_type n, size_type new_capacity) {
+        size_type before = pos - start;
+        size_type after = finish - pos;
+        relocate_storage(before, after, n, new_capacity, can_reallocate());
+        finish = start + before + n + after;
+        end_of_storage = start + new_capacity;
+        return start + before;
+    }
+    void relocate_storage(size_type before, size_type after, size_type n,
+                          size_type new_capacity, __true_type) {
+        if(start == 0) {
+            start = data_allocator::allocate(this->get_alloc(), new_capacity);
+            return;
+        }
+        start = data_allocator::reallocate(this->get_alloc(), start, capacity(), new_capacity);
+        if(n != 0 && after != 0) {
+            memmove((void*)(start + before + n), (void*)(start + before), after * sizeof(T));
+        }
+    }
+    void relocate_storage(size_type before, size_type after, size_type n,
+                          size_type new_capacity, __false_type) {
+        iterator new_start = data_allocator::allocate(this->get_alloc(), new_capacity);
+        if(start) {
+            memcpy((void*)new_start, (void*)start, before * sizeof(T));
+            memcpy((void*)(new_start + before + n), (void*)(start + before), after * sizeof(T));
+            deallocate();
+        }
+        start = new_start;
+    }
+    // Closes a gap from relocate_with_gap whose elements failed to construct.
+    void close_gap(iterator gap, size_type n) {
+        memmove((void*)gap, (void*)(gap + n), (finish - gap - n) * sizeof(T));
+        finish -= n;
+    }
+    void reserve_aux(size_type n, __true_type) {
+        relocate_with_gap(finish, 0, n);
+    }
+    void reserve_aux(size_type n, __false_type) {
+        size_type old = size();
+        iterator tmp = allocate_and_move(n, start, finish);
+        destory(start, finish);
+        deallocate();
+        start = tmp;
+        finish = start + old;
+        end_of_storage = start + n;
+    }
+
     void fill_initialize(size_type n, const T& value) {
         start = allocate_and_fill(n, value);
         finish = end_of_storage = start + n;
     }
 public:
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
     iterator begin() {
         return start;
     }
@@ -91,54 +189,62 @@ public:
     }
 
     vector() : start(0), finish(0), end_of_storage(0) {}
-    vector(size_type n, const T& value) {
+    explicit vector(const allocator_type& a) :
+        alloc_base(a), start(0), finish(0), end_of_storage(0) {}
+    vector(size_type n, const T& value, const allocator_type& a = allocator_type()) :
+        alloc_base(a) {
         fill_initialize(n, value);
     }
-    vector(int n, const T& value) {
+    vector(int n, const T& value, const allocator_type& a = allocator_type()) :
+        alloc_base(a) {
         fill_initialize(n, value);
     }
-    vector(long n, const T& value) {
+    vector(long n, const T& value, const allocator_type& a = allocator_type()) :
+        alloc_base(a) {
         fill_initialize(n, value);
     }
     explicit vector(size_type n) {
         fill_initialize(n, T());
     }
 
-    vector(const vector<T, Alloc>& x) {
+    vector(const vector<T, Alloc>& x) :
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())),
+        start(0), finish(0), end_of_storage(0) {
         range_initialize(x.begin(), x.end(), category_type(x.begin()));
     }
+    vector(vector<T, Alloc>&& x) :
+        alloc_base(x.get_alloc()),
+        start(x.start), finish(x.finish), end_of_storage(x.end_of_storage) {
+        x.start = x.finish = x.end_of_storage = 0;
+    }
 #ifdef __STL_MEMBER_TEMPLATES
     template <class InputIterator>
-    vector(InputIterator first, InputIterator last) :
-        start(0), finish(0), end_of_storage(0) {
+    vector(InputIterator first, InputIterator last,
+           const allocator_type& a = allocator_type()) :
+        alloc_base(a), start(0), finish(0), end_of_storage(0) {
         range_initialize(first, last, category_type(first));
     }
 #else /* __STL_MEMBER_TEMPLATES */
-    vector(const_iterator first, const_iterator last) {
+    vector(const_iterator first, const_iterator last,
+           const allocator_type& a = allocator_type()) :
+        alloc_base(a), start(0), finish(0), end_of_storage(0) {
         range_initialize(first, last, category_type(first));
     }
 #endif /* __STL_MEMBER_TEMPLATES */
     ~vector() {
-        destory(start, end_of_storage);
+        destory(start, finish);
         deallocate();
     }
     vector<T, Alloc>& operator=(const vector<T, Alloc>& x);
+    vector<T, Alloc>& operator=(vector<T, Alloc>&& x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
     void reserve(size_type n) {
         if(n > capacity()) {
-            iterator tmp;
-            size_type old = size();
-            try {
-                tmp = allocate_and_copy(n, start, finish);
-            } catch(...) {
-                destory(tmp, tmp + old);
-                data_allocator::deallocate(tmp, n);
-                throw;
-            }
-            destory(start, finish);
-            deallocate();
-            start = tmp;
-            finish = start + old;
-            end_of_storage = start + n;
+            reserve_aux(n, relocatable());
         }
     }
     reference front() {
@@ -160,7 +266,21 @@ public:
             insert_aux(finish, x);
         }
     }
+    void push_back(T&& x) {
+        emplace_back(std::move(x));
+    }
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        if(finish != end_of_storage) {
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
+        } else {
+            insert_aux(finish, std::forward<Args>(args)...);
+        }
+    }
     void swap(vector<T, Alloc>& x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
         std::swap(start, x.start);
         std::swap(finish, x.finish);
         std::swap(end_of_storage, x.end_of_storage);
@@ -174,6 +294,20 @@ public:
         }
         return start + n;
     }
+    iterator insert(iterator position, T&& x) {
+        return emplace(position, std::move(x));
+    }
+    template <class... Args>
+    iterator emplace(iterator position, Args&&... args) {
+        size_type n = position - start;
+        if (finish != end_of_storage && position == finish) {
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
+        } else {
+            insert_aux(position, std::forward<Args>(args)...);
+        }
+        return start + n;
+    }
     iterator insert(iterator position) {
         return insert(position, T());
     }
@@ -201,14 +335,16 @@ public:
     }
     iterator erase(iterator position) {
         if((position + 1) != finish)
-            std::copy(position + 1, finish, position);
+            std::move(position + 1, finish, position);
         destory(--finish);
         return position;
     }
     iterator erase(iterator first, iterator last) {
+        if(first == last)
+            return first;
         if(last != finish)
-            std::copy(last, finish, first);
-        difference_type n = distance(first, last);
+            std::move(last, finish, first);
+        difference_type n = hh_std::distance(first, last);
         while(n > 0) {
             destory(--finish);
             n--;
@@ -231,9 +367,28 @@ public:
     }
 
 protected:
+    void fill_insert_realloc(iterator pos, size_type n, const T& x, size_type new_size, __true_type);
+    void fill_insert_realloc(iterator pos, size_type n, const T& x, size_type new_size, __false_type);
+
     iterator allocate_and_fill(size_type n, const T& x) {
-        iterator unini = data_allocator::allocate(n);
-        uninitialized_fill(unini, unini + n, x);
+        iterator unini = data_allocator::allocate(this->get_alloc(), n);
+        try {
+            uninitialized_fill(unini, unini + n, x);
+        } catch(...) {
+            data_allocator::deallocate(this->get_alloc(), unini, n);
+            throw;
+        }
+        return unini;
+    }
+
+    iterator allocate_and_move(size_type n, iterator first, iterator last) {
+        iterator unini = data_allocator::allocate(this->get_alloc(), n);
+        try {
+            uninitialized_move(first, last, unini);
+        } catch(...) {
+            data_allocator::deallocate(this->get_alloc(), unini, n);
+            throw;
+        }
         return unini;
     }
 
@@ -241,15 +396,25 @@ protected:
     template <class ForwardIterator>
     iterator allocate_and_copy(size_type n,
                                ForwardIterator first, ForwardIterator last) {
-        iterator unini = data_allocator::allocate(n);
-        uninitialized_copy(first, last, unini);
+        iterator unini = data_allocator::allocate(this->get_alloc(), n);
+        try {
+            uninitialized_copy(first, last, unini);
+        } catch(...) {
+            data_allocator::deallocate(this->get_alloc(), unini, n);
+            throw;
+        }
         return unini;
     }
 #else /* __STL_MEMBER_TEMPLATES */
     iterator allocate_and_copy(size_type n,
                                const_iterator first, const_iterator last) {
-        iterator unini = data_allocator::allocate(n);
-        uninitialized_copy(first, last, unini);
+        iterator unini = data_allocator::allocate(this->get_alloc(), n);
+        try {
+            uninitialized_copy(first, last, unini);
+        } catch(...) {
+            data_allocator::deallocate(this->get_alloc(), unini, n);
+            throw;
+        }
         return unini;
     }
 #endif /* __STL_MEMBER_TEMPLATES */
@@ -285,6 +450,13 @@ protected:
                       ForwardIterator first, ForwardIterator last,
                       forward_iterator_tag);
 
+    template <class ForwardIterator>
+    void range_insert_realloc(iterator pos, ForwardIterator first, ForwardIterator last,
+                              size_type n, size_type new_size, __true_type);
+    template <class ForwardIterator>
+    void range_insert_realloc(iterator pos, ForwardIterator first, ForwardIterator last,
+                              size_type n, size_type new_size, __false_type);
+
 #endif /* __STL_MEMBER_TEMPLATES */
 };
 
@@ -300,42 +472,32 @@ void vector<T, Alloc>::range_insert(iterator pos, InputIterator first, InputIter
 template <class T, class Alloc>
 template <class ForwardIterator>
 void vector<T, Alloc>::range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
-    size_type insert_size = distance(first, last);
+    size_type insert_size = hh_std::distance(first, last);
+    if(insert_size == 0) {
+        return;
+    }
     if(insert_size > (end_of_storage - finish)) {
         size_type old_size = size();
         size_type new_size = old_size + (old_size > insert_size ? old_size : insert_size);
-        iterator new_start, new_finish;
-        try {
-            new_start = data_allocator::allocate(new_size);
-            new_finish = uninitialized_copy(start, pos, new_start);
-            new_finish = uninitialized_copy(first, last, new_finish);
-            new_finish = uninitialized_copy(pos, finish, new_finish);
-        } catch(...) {
-            destory(new_start, new_finish);
-            data_allocator::deallocate(new_start, new_size);
-            throw;
-        }
-        destory(start, finish);
-        deallocate();
-        start = new_start;
-        finish = new_finish;
-        end_of_storage = start + new_size;
+        range_insert_realloc(pos, first, last, insert_size, new_size, relocatable());
     } else {
         if (pos == finish) {
             finish = uninitialized_copy(first, last, finish);
         } else {
             size_type old_right_size = finish - pos;
             if(old_right_size <= insert_size) {
-                uninitialized_copy(pos, finish, pos + insert_size);
+                uninitialized_move(pos, finish, pos + insert_size);
                 if(old_right_size == insert_size) {
                     std::copy(first, last, pos);
                 } else {
-                    std::copy(first, first + old_right_size, pos);
-                    uninitialized_copy(first + old_right_size, last, finish);
+                    ForwardIterator mid = first;
+                    hh_std::advance(mid, old_right_size);
+                    std::copy(first, mid, pos);
+                    uninitialized_copy(mid, last, finish);
                 }
             } else {
-                uninitialized_copy(finish - insert_size, finish, finish);
-                std::copy(pos, finish - insert_size, finish - (old_right_size - insert_size));
+                uninitialized_move(finish - insert_size, finish, finish);
+                std::move_backward(pos, finish - insert_size, finish);
                 std::copy(first, last, pos);
             }
             finish += insert_size;
@@ -343,46 +505,106 @@ void vector<T, Alloc>::range_insert(iterator pos, ForwardIterator first, Forward
     }
 }
 
+template <class T, class Alloc>
+template <class ForwardIterator>
+void vector<T, Alloc>::range_insert_realloc(iterator pos, ForwardIterator first, ForwardIterator last,
+                                            size_type n, size_type new_size, __true_type) {
+    iterator gap = relocate_with_gap(pos, n, new_size);
+    try {
+        uninitialized_copy(first, last, gap);
+    } catch(...) {
+        close_gap(gap, n);
+        throw;
+    }
+}
+
+template <class T, class Alloc>
+template <class ForwardIterator>
+void vector<T, Alloc>::range_insert_realloc(iterator pos, ForwardIterator first, ForwardIterator last,
+                                            size_type, size_type new_size, __false_type) {
+    iterator new_start = data_allocator::allocate(this->get_alloc(), new_size);
+    iterator new_finish = new_start;
+    try {
+        new_finish = uninitialized_move_if_noexcept(start, pos, new_start);
+        for(; first != last; ++first, ++new_finish) {
+            construct(&*new_finish, *first);
+        }
+        new_finish = uninitialized_move_if_noexcept(pos, finish, new_finish);
+    } catch(...) {
+        destory(new_start, new_finish);
+        data_allocator::deallocate(this->get_alloc(), new_start, new_size);
+        throw;
+    }
+    destory(start, finish);
+    deallocate();
+    start = new_start;
+    finish = new_finish;
+    end_of_storage = start + new_size;
+}
+
+template <class T, class Alloc>
+void vector<T, Alloc>::fill_insert_realloc(iterator pos, size_type n, const T &x,
+                                           size_type new_size, __true_type) {
+    iterator gap = relocate_with_gap(pos, n, new_size);
+    try {
+        uninitialized_fill_n(gap, n, x);
+    } catch(...) {
+        close_gap(gap, n);
+        throw;
+    }
+}
+
+template <class T, class Alloc>
+void vector<T, Alloc>::fill_insert_realloc(iterator pos, size_type n, const T &x,
+                                           size_type new_size, __false_type) {
+    iterator new_start = data_allocator::allocate(this->get_alloc(), new_size);
+    iterator new_finish = new_start;
+    try {
+        new_finish = uninitialized_move_if_noexcept(start, pos, new_start);
+        for(size_type i = 0; i < n; ++i, ++new_finish) {
+            construct(new_finish, x);
+        }
+        new_finish = uninitialized_move_if_noexcept(pos, finish, new_finish);
+    } catch(...) {
+        destory(new_start, new_finish);
+        data_allocator::deallocate(this->get_alloc(), new_start, new_size);
+        throw;
+    }
+    destory(start, finish);
+    deallocate();
+    start = new_start;
+    finish = new_finish;
+    end_of_storage = start + new_size;
+}
+
 template <class T, class Alloc>
 void vector<T, Alloc>::insert(iterator pos, size_type n, const T &x) {
+    if(n == 0) {
+        return;
+    }
+    T x_copy(x);    // x may be an element that is about to move
     if(n > (end_of_storage - finish)) {
         size_type old_size = size();
         size_type new_size = old_size + (old_size > n ? old_size : n);
-        iterator new_start, new_finish;
-        try {
-            new_start = data_allocator::allocate(new_size);
-            new_finish = uninitialized_copy(start, pos, new_start);
-            uninitialized_fill_n(new_finish, n, x);
-            new_finish += n;
-            new_finish = uninitialized_copy(pos, finish, new_finish);
-        } catch(...) {
-            destory(new_start, new_finish);
-            data_allocator::deallocate(new_start, new_size);
-            throw;
-        }
-        destory(start, finish);
-        deallocate();
-        start = new_start;
-        finish = new_finish;
-        end_of_storage = start + new_size;
+        fill_insert_realloc(pos, n, x_copy, new_size, relocatable());
     } else {
         if (pos == finish) {
-            uninitialized_fill_n(finish, n, x);
+            uninitialized_fill_n(finish, n, x_copy);
             finish += n;
         } else {
             size_type old_right_size = finish - pos;
             if(old_right_size <= n) {
-                uninitialized_copy(pos, finish, pos + n);
+                uninitialized_move(pos, finish, pos + n);
                 if(old_right_size == n) {
-                    std::fill_n(pos, n, x);
+                    std::fill_n(pos, n, x_copy);
                 } else {
-                    std::fill_n(pos, old_right_size, x);
-                    uninitialized_fill_n(finish, n - old_right_size, x);
+                    std::fill_n(pos, old_right_size, x_copy);
+                    uninitialized_fill_n(finish, n - old_right_size, x_copy);
                 }
             } else {
-                uninitialized_copy(finish - n, finish, finish);
-                std::copy(pos, finish - n, finish - (old_right_size - n));
-                std::fill_n(pos, n, x);
+                uninitialized_move(finish - n, finish, finish);
+                std::move_backward(pos, finish - n, finish);
+                std::fill_n(pos, n, x_copy);
             }
             finish += n;
         }
@@ -396,33 +618,70 @@ void vector<T, Alloc>::insert(iterator pos, const_iterator first, const_iterator
 }
 #endif
 template <class T, class Alloc>
-void vector<T, Alloc>::insert_aux(iterator position, const T &x) {
+template <class... Args>
+void vector<T, Alloc>::insert_aux(iterator position, Args&&... args) {
     if(finish != end_of_storage) {
         if(position == finish) {
-            construct(finish++, x);
+            construct(finish, std::forward<Args>(args)...);
+            ++finish;
         } else {
-            construct(finish, finish - 1);
-            std::copy(position, finish, position + 1);
+            T x_copy(std::forward<Args>(args)...);
+            construct(finish, std::move(*(finish - 1)));
             finish++;
-            destory(position);
-            construct(position, x);
+            std::move_backward(position, finish - 2, finish - 1);
+            *position = std::move(x_copy);
         }
     } else {
-        iterator new_start, new_finish;
-        size_type new_capacity = (capacity() == 0 ? 1 : 2 * capacity());
-        try {
-            new_start = allocate_and_copy(new_capacity, start, finish);
-            new_finish = new_start + size();
-            construct(new_finish++, x);
-        } catch(...) {
-            destory(new_start, new_finish);
-            data_allocator::deallocate(new_start, capacity() * 2);
-            throw;
+        realloc_insert(position, relocatable(), std::forward<Args>(args)...);
+    }
+}
+
+template <class T, class Alloc>
+template <class... Args>
+void vector<T, Alloc>::realloc_insert(iterator position, __true_type, Args&&... args) {
+    size_type new_capacity = (capacity() == 0 ? 1 : 2 * capacity());
+    T x_copy(std::forward<Args>(args)...);  // args may refer into the block that is about to move
+    iterator gap = relocate_with_gap(position, 1, new_capacity);
+    try {
+        construct(gap, std::move(x_copy));
+    } catch(...) {
+        close_gap(gap, 1);
+        throw;
+    }
+}
+
+template <class T, class Alloc>
+template <class... Args>
+void vector<T, Alloc>::realloc_insert(iterator position, __false_type, Args&&... args) {
+    size_type new_capacity = (capacity() == 0 ? 1 : 2 * capacity());
+    size_type n = position - start;
+    iterator new_start = data_allocator::allocate(this->get_alloc(), new_capacity);
+    iterator new_finish = new_start;
+    try {
+        // Build the new element first: args may refer into the old block.
+        construct(new_start + n, std::forward<Args>(args)...);
+    } catch(...) {
+        data_allocator::deallocate(this->get_alloc(), new_start, new_capacity);
+        throw;
+    }
+    try {
+        new_finish = uninitialized_move_if_noexcept(start, position, new_start);
+        ++new_finish;
+        new_finish = uninitialized_move_if_noexcept(position, finish, new_finish);
+    } catch(...) {
+        // If the prefix failed, the new element is not in [new_start, new_finish).
+        if(new_finish == new_start) {
+            destory(new_start + n);
         }
-        end_of_storage = new_start + new_capacity;
-        start = new_start;
-        finish = new_finish;
+        destory(new_start, new_finish);
+        data_allocator::deallocate(this->get_alloc(), new_start, new_capacity);
+        throw;
     }
+    destory(start, finish);
+    deallocate();
+    end_of_storage = new_start + new_capacity;
+    start = new_start;
+    finish = new_finish;
 }
 
 template <class T, class Alloc>
@@ -473,15 +732,9 @@ inline void swap (vector<T, Alloc> &a, vector<T, Alloc> &b) {
 template <class T, class Alloc>
 vector<T, Alloc> &vector<T, Alloc>::operator= (const vector<T, Alloc> &x) {
     if(&x != this) {
+        copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
         if (x.size() > capacity()) {
-            iterator new_start;
-            try {
-                new_start = allocate_and_copy(x.size(), x.begin(), x.end());
-            } catch(...) {
-                destory(new_start, new_start + x.size());
-                data_allocator::deallocate(new_start, x.size());
-                throw;
-            }
+            iterator new_start = allocate_and_copy(x.size(), x.begin(), x.end());
             destory(start, finish);
             deallocate();
             start = new_start;
@@ -499,6 +752,666 @@ vector<T, Alloc> &vector<T, Alloc>::operator= (const vector<T, Alloc> &x) {
     return *this;
 }
 
+// vector<bool> packs its flags into unsigned long words.  Whole-word loops
+// do the bulk work (count, find, and/or/xor, fill); they are kept simple
+// so the compiler can vectorize them.
+typedef unsigned long __bit_word;
+enum {__WORD_BIT = int(sizeof(__bit_word) * 8)};
+
+inline size_t __bit_popcount(__bit_word word) {
+#if defined(__GNUC__)
+    return __builtin_popcountl(word);
+#else
+    size_t n = 0;
+    while(word) {
+        word &= word - 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline size_t __bit_first(__bit_word word) {
+#if defined(__GNUC__)
+    return __builtin_ctzl(word);
+#else
+    size_t bit = 0;
+    while((word & 1) == 0) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+struct __bit_reference {
+    __bit_word *p;
+    __bit_word mask;
+    __bit_reference(__bit_word *x, __bit_word y): p(x), mask(y) {}
+    __bit_reference(): p(0), mask(0) {}
+
+    operator bool() const {
+        return (*p & mask) != 0;
+    }
+    __bit_reference &operator= (bool x) {
+        if(x) {
+            *p |= mask;
+        } else {
+            *p &= ~mask;
+        }
+        return *this;
+    }
+    __bit_reference &operator= (const __bit_reference &x) {
+        return *this = bool(x);
+    }
+    bool operator== (const __bit_reference &x) const {
+        return bool(*this) == bool(x);
+    }
+    bool operator< (const __bit_reference &x) const {
+        return !bool(*this) && bool(x);
+    }
+    void flip() {
+        *p ^= mask;
+    }
+};
+
+inline void swap(__bit_reference x, __bit_reference y) {
+    bool tmp = x;
+    x = y;
+    y = tmp;
+}
+
+struct __bit_iterator_base {
+    __bit_word *p;
+    unsigned int offset;
+
+    __bit_iterator_base(__bit_word *x, unsigned int y): p(x), offset(y) {}
+
+    void bump_up() {
+        if(offset++ == __WORD_BIT - 1) {
+            offset = 0;
+            ++p;
+        }
+    }
+    void bump_down() {
+        if(offset-- == 0) {
+            offset = __WORD_BIT - 1;
+            --p;
+        }
+    }
+    void incr(ptrdiff_t i) {
+        ptrdiff_t n = i + offset;
+        p += n / __WORD_BIT;
+        n = n % __WORD_BIT;
+        if(n < 0) {
+            offset = (unsigned int)(n + __WORD_BIT);
+            --p;
+        } else {
+            offset = (unsigned int)n;
+        }
+    }
+    bool operator== (const __bit_iterator_base &x) const {
+        return p == x.p && offset == x.offset;
+    }
+    bool operator!= (const __bit_iterator_base &x) const {
+        return p != x.p || offset != x.offset;
+    }
+    bool operator< (const __bit_iterator_base &x) const {
+        return p < x.p || (p == x.p && offset < x.offset);
+    }
+    bool operator> (const __bit_iterator_base &x) const {
+        return x < *this;
+    }
+    bool operator<= (const __bit_iterator_base &x) const {
+        return !(x < *this);
+    }
+    bool operator>= (const __bit_iterator_base &x) const {
+        return !(*this < x);
+    }
+};
+
+inline ptrdiff_t operator- (const __bit_iterator_base &x, const __bit_iterator_base &y) {
+    return __WORD_BIT * (x.p - y.p) + x.offset - y.offset;
+}
+
+struct __bit_iterator: public __bit_iterator_base {
+    typedef random_access_iterator_tag iterator_category;
+    typedef bool value_type;
+    typedef ptrdiff_t difference_type;
+    typedef __bit_reference reference;
+    typedef __bit_reference* pointer;
+    typedef __bit_iterator iterator;
+
+    __bit_iterator(): __bit_iterator_base(0, 0) {}
+    __bit_iterator(__bit_word *x, unsigned int y): __bit_iterator_base(x, y) {}
+
+    reference operator* () const {
+        return reference(p, __bit_word(1) << offset);
+    }
+    iterator &operator++ () {
+        bump_up();
+        return *this;
+    }
+    iterator operator++ (int) {
+        iterator tmp = *this;
+        bump_up();
+        return tmp;
+    }
+    iterator &operator-- () {
+        bump_down();
+        return *this;
+    }
+    iterator operator-- (int) {
+        iterator tmp = *this;
+        bump_down();
+        return tmp;
+    }
+    iterator &operator+= (difference_type i) {
+        incr(i);
+        return *this;
+    }
+    iterator &operator-= (difference_type i) {
+        incr(-i);
+        return *this;
+    }
+    iterator operator+ (difference_type i) const {
+        iterator tmp = *this;
+        return tmp += i;
+    }
+    iterator operator- (difference_type i) const {
+        iterator tmp = *this;
+        return tmp -= i;
+    }
+    reference operator[] (difference_type i) const {
+        return *(*this + i);
+    }
+};
+
+inline __bit_iterator operator+ (ptrdiff_t n, const __bit_iterator &x) {
+    return x + n;
+}
+
+struct __bit_const_iterator: public __bit_iterator_base {
+    typedef random_access_iterator_tag iterator_category;
+    typedef bool value_type;
+    typedef ptrdiff_t difference_type;
+    typedef bool reference;
+    typedef bool const_reference;
+    typedef const bool* pointer;
+    typedef __bit_const_iterator const_iterator;
+
+    __bit_const_iterator(): __bit_iterator_base(0, 0) {}
+    __bit_const_iterator(__bit_word *x, unsigned int y): __bit_iterator_base(x, y) {}
+    __bit_const_iterator(const __bit_iterator &x): __bit_iterator_base(x.p, x.offset) {}
+
+    const_reference operator* () const {
+        return (*p & (__bit_word(1) << offset)) != 0;
+    }
+    const_iterator &operator++ () {
+        bump_up();
+        return *this;
+    }
+    const_iterator operator++ (int) {
+        const_iterator tmp = *this;
+        bump_up();
+        return tmp;
+    }
+    const_iterator &operator-- () {
+        bump_down();
+        return *this;
+    }
+    const_iterator operator-- (int) {
+        const_iterator tmp = *this;
+        bump_down();
+        return tmp;
+    }
+    const_iterator &operator+= (difference_type i) {
+        incr(i);
+        return *this;
+    }
+    const_iterator &operator-= (difference_type i) {
+        incr(-i);
+        return *this;
+    }
+    const_iterator operator+ (difference_type i) const {
+        const_iterator tmp = *this;
+        return tmp += i;
+    }
+    const_iterator operator- (difference_type i) const {
+        const_iterator tmp = *this;
+        return tmp -= i;
+    }
+    const_reference operator[] (difference_type i) const {
+        return *(*this + i);
+    }
+};
+
+inline __bit_const_iterator operator+ (ptrdiff_t n, const __bit_const_iterator &x) {
+    return x + n;
+}
+
+template <class Alloc>
+class vector<bool, Alloc>: private __alloc_holder<Alloc> {
+public:
+    typedef bool value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef __bit_reference reference;
+    typedef bool const_reference;
+    typedef __bit_reference* pointer;
+    typedef const bool* const_pointer;
+    typedef __bit_iterator iterator;
+    typedef __bit_const_iterator const_iterator;
+    typedef Alloc allocator_type;
+
+    typedef reverse_iterator<const_iterator> const_r_iterator;
+    typedef reverse_iterator<iterator> r_iterator;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+    typedef simple_alloc<__bit_word, Alloc> data_allocator;
+
+    iterator start;
+    iterator finish;
+    __bit_word *end_of_storage;
+
+    static size_type words(size_type n) {
+        return (n + __WORD_BIT - 1) / __WORD_BIT;
+    }
+    // Bits of the last word that lie past size() hold garbage; every word
+    // kernel masks them with this.
+    __bit_word tail_mask() const {
+        return finish.offset == 0 ? ~__bit_word(0) : (__bit_word(1) << finish.offset) - 1;
+    }
+    size_type word_count() const {
+        return words(size());
+    }
+    // Word i of x for combining into *this.  When x is the shorter operand,
+    // the bits of its last word past x.size() read as pad instead of garbage.
+    __bit_word operand_word(const vector<bool, Alloc> &x, size_type i, __bit_word pad) const {
+        __bit_word w = x.start.p[i];
+        if(x.size() < size() && i + 1 == x.word_count()) {
+            w = (w & x.tail_mask()) | (pad & ~x.tail_mask());
+        }
+        return w;
+    }
+    __bit_word *bit_alloc(size_type n) {
+        return data_allocator::allocate(this->get_alloc(), words(n));
+    }
+    void deallocate() {
+        if(start.p) {
+            data_allocator::deallocate(this->get_alloc(), start.p, end_of_storage - start.p);
+        }
+    }
+    void initialize(size_type n) {
+        __bit_word *q = n ? bit_alloc(n) : 0;
+        start = iterator(q, 0);
+        finish = start + difference_type(n);
+        end_of_storage = q + words(n);
+    }
+    // Moves the bits into a block that holds at least n, word by word.
+    void reallocate_words(size_type n) {
+        __bit_word *q = bit_alloc(n);
+        size_type len = size();
+        if(start.p) {
+            memcpy(q, start.p, word_count() * sizeof(__bit_word));
+        }
+        deallocate();
+        start = iterator(q, 0);
+        finish = start + difference_type(len);
+        end_of_storage = q + words(n);
+    }
+    size_type next_capacity(size_type n) const {
+        size_type len = size() + std::max(size(), n);
+        return len < size_type(__WORD_BIT) ? size_type(__WORD_BIT) : len;
+    }
+    // Index of the first bit at or after pos that equals !invert, or size().
+    size_type find_from(size_type pos, __bit_word invert) const {
+        size_type n = word_count();
+        size_type w = pos / __WORD_BIT;
+        if(pos >= size()) {
+            return size();
+        }
+        __bit_word word = (start.p[w] ^ invert) & (~__bit_word(0) << (pos % __WORD_BIT));
+        while(true) {
+            if(w == n - 1) {
+                word &= tail_mask();
+            }
+            if(word) {
+                return w * __WORD_BIT + __bit_first(word);
+            }
+            if(++w == n) {
+                return size();
+            }
+            word = start.p[w] ^ invert;
+        }
+    }
+
+    void copy_assign_alloc(const vector<bool, Alloc> &x, __true_type) {
+        deallocate();
+        initialize(0);
+        this->get_alloc() = x.get_alloc();
+    }
+    void copy_assign_alloc(const vector<bool, Alloc> &, __false_type) {
+    }
+    void move_assign(vector<bool, Alloc> &x, __true_type) {
+        deallocate();
+        this->get_alloc() = x.get_alloc();
+        start = x.start;
+        finish = x.finish;
+        end_of_storage = x.end_of_storage;
+        x.initialize(0);
+    }
+    void move_assign(vector<bool, Alloc> &x, __false_type) {
+        *this = x;
+        x.clear();
+    }
+
+    template <class Integer>
+    void initialize_dispatch(Integer n, Integer x, __true_type) {
+        initialize(size_type(n));
+        fill(bool(x));
+    }
+    template <class InputIterator>
+    void initialize_dispatch(InputIterator first, InputIterator last, __false_type) {
+        initialize(0);
+        insert(end(), first, last);
+    }
+    template <class ForwardIterator>
+    void range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+        size_type n = hh_std::distance(first, last);
+        iterator gap = open_gap(pos, n);
+        std::copy(first, last, gap);
+    }
+    template <class InputIterator>
+    void range_insert(iterator pos, InputIterator first, InputIterator last, input_iterator_tag) {
+        for(; first != last; ++first) {
+            pos = insert(pos, *first);
+            ++pos;
+        }
+    }
+    // Makes room for n bits at pos and returns the first of them.
+    iterator open_gap(iterator pos, size_type n) {
+        size_type off = pos - start;
+        if(n > capacity() - size()) {
+            reallocate_words(next_capacity(n));
+        }
+        pos = start + difference_type(off);
+        iterator old_finish = finish;
+        finish += difference_type(n);
+        std::copy_backward(pos, old_finish, finish);
+        return pos;
+    }
+public:
+    vector() {
+        initialize(0);
+    }
+    explicit vector(const allocator_type &a): alloc_base(a) {
+        initialize(0);
+    }
+    vector(size_type n, bool value, const allocator_type &a = allocator_type()): alloc_base(a) {
+        initialize(n);
+        fill(value);
+    }
+    explicit vector(size_type n) {
+        initialize(n);
+        fill(false);
+    }
+    template <class InputIterator>
+    vector(InputIterator first, InputIterator last, const allocator_type &a = allocator_type()): alloc_base(a) {
+        typedef typename __bool_type<std::is_integral<InputIterator>::value>::type integral;
+        initialize_dispatch(first, last, integral());
+    }
+    vector(const vector<bool, Alloc> &x):
+        alloc_base(__alloc_traits<Alloc>::select_on_copy_construction(x.get_alloc())) {
+        initialize(x.size());
+        if(x.size()) {
+            memcpy(start.p, x.start.p, x.word_count() * sizeof(__bit_word));
+        }
+    }
+    vector(vector<bool, Alloc> &&x):
+        alloc_base(x.get_alloc()), start(x.start), finish(x.finish), end_of_storage(x.end_of_storage) {
+        x.initialize(0);
+    }
+    ~vector() {
+        deallocate();
+    }
+    vector<bool, Alloc> &operator= (const vector<bool, Alloc> &x) {
+        if(&x != this) {
+            copy_assign_alloc(x, typename __alloc_traits<Alloc>::propagate_on_copy_assignment());
+            if(x.size() > capacity()) {
+                deallocate();
+                initialize(x.size());
+            } else {
+                finish = start + difference_type(x.size());
+            }
+            if(x.size()) {
+                memcpy(start.p, x.start.p, x.word_count() * sizeof(__bit_word));
+            }
+        }
+        return *this;
+    }
+    vector<bool, Alloc> &operator= (vector<bool, Alloc> &&x) {
+        if(&x != this) {
+            move_assign(x, typename __alloc_traits<Alloc>::propagate_on_move_assignment());
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    iterator begin() {
+        return start;
+    }
+    const_iterator begin() const {
+        return start;
+    }
+    iterator end() {
+        return finish;
+    }
+    const_iterator end() const {
+        return finish;
+    }
+    r_iterator rbegin() {
+        return r_iterator(end());
+    }
+    const_r_iterator rbegin() const {
+        return const_r_iterator(end());
+    }
+    r_iterator rend() {
+        return r_iterator(begin());
+    }
+    const_r_iterator rend() const {
+        return const_r_iterator(begin());
+    }
+    size_type size() const {
+        return size_type(const_iterator(finish) - const_iterator(start));
+    }
+    size_type max_size() const {
+        return size_type(-1);
+    }
+    size_type capacity() const {
+        return size_type(const_iterator(end_of_storage, 0) - const_iterator(start));
+    }
+    bool empty() const {
+        return start == finish;
+    }
+    reference operator[] (size_type n) {
+        return *(start + difference_type(n));
+    }
+    const_reference operator[] (size_type n) const {
+        return *(const_iterator(start) + difference_type(n));
+    }
+    reference at(size_type n) {
+        return (*this)[n];
+    }
+    const_reference at(size_type n) const {
+        return (*this)[n];
+    }
+    reference front() {
+        return *begin();
+    }
+    const_reference front() const {
+        return *begin();
+    }
+    reference back() {
+        return *(end() - 1);
+    }
+    const_reference back() const {
+        return *(end() - 1);
+    }
+    void reserve(size_type n) {
+        if(n > capacity()) {
+            reallocate_words(n);
+        }
+    }
+    void push_back(bool x) {
+        if(finish.p == end_of_storage) {
+            reallocate_words(next_capacity(1));
+        }
+        *finish = x;
+        ++finish;
+    }
+    void pop_back() {
+        --finish;
+    }
+    void swap(vector<bool, Alloc> &x) {
+        __alloc_swap(this->get_alloc(), x.get_alloc(),
+                     typename __alloc_traits<Alloc>::propagate_on_swap());
+        std::swap(start, x.start);
+        std::swap(finish, x.finish);
+        std::swap(end_of_storage, x.end_of_storage);
+    }
+    iterator insert(iterator pos, bool x) {
+        iterator gap = open_gap(pos, 1);
+        *gap = x;
+        return gap;
+    }
+    void insert(iterator pos, size_type n, bool x) {
+        iterator gap = open_gap(pos, n);
+        std::fill(gap, gap + difference_type(n), x);
+    }
+    void insert(iterator pos, int n, bool x) {
+        insert(pos, size_type(n), x);
+    }
+    void insert(iterator pos, long n, bool x) {
+        insert(pos, size_type(n), x);
+    }
+    template <class InputIterator>
+    void insert(iterator pos, InputIterator first, InputIterator last) {
+        range_insert(pos, first, last, category_type(first));
+    }
+    iterator erase(iterator pos) {
+        if(pos + 1 != finish) {
+            std::copy(pos + 1, finish, pos);
+        }
+        --finish;
+        return pos;
+    }
+    iterator erase(iterator first, iterator last) {
+        finish = std::copy(last, finish, first);
+        return first;
+    }
+    void resize(size_type new_size, bool x = false) {
+        if(new_size < size()) {
+            erase(begin() + difference_type(new_size), end());
+        } else {
+            insert(end(), new_size - size(), x);
+        }
+    }
+    void clear() {
+        finish = start;
+    }
+
+    // Number of set bits.
+    size_type count() const {
+        size_type n = word_count();
+        if(n == 0) {
+            return 0;
+        }
+        size_type result = 0;
+        for(size_type i = 0; i + 1 < n; ++i) {
+            result += __bit_popcount(start.p[i]);
+        }
+        return result + __bit_popcount(start.p[n - 1] & tail_mask());
+    }
+    bool any() const {
+        return find_first() != size();
+    }
+    bool all() const {
+        return find_first_unset() == size();
+    }
+    // The find_* members return size() when there is no such bit.
+    size_type find_first() const {
+        return find_from(0, 0);
+    }
+    size_type find_next(size_type pos) const {
+        return find_from(pos + 1, 0);
+    }
+    size_type find_first_unset() const {
+        return find_from(0, ~__bit_word(0));
+    }
+    size_type find_next_unset(size_type pos) const {
+        return find_from(pos + 1, ~__bit_word(0));
+    }
+    void fill(bool x) {
+        if(start.p) {
+            memset(start.p, x ? 0xff : 0, word_count() * sizeof(__bit_word));
+        }
+    }
+    void flip() {
+        for(size_type i = 0, n = word_count(); i < n; ++i) {
+            start.p[i] = ~start.p[i];
+        }
+    }
+    // The bitwise operators combine the first min(size(), x.size()) bits.
+    vector<bool, Alloc> &operator&= (const vector<bool, Alloc> &x) {
+        for(size_type i = 0, n = std::min(word_count(), x.word_count()); i < n; ++i) {
+            start.p[i] &= operand_word(x, i, ~__bit_word(0));
+        }
+        return *this;
+    }
+    vector<bool, Alloc> &operator|= (const vector<bool, Alloc> &x) {
+        for(size_type i = 0, n = std::min(word_count(), x.word_count()); i < n; ++i) {
+            start.p[i] |= operand_word(x, i, 0);
+        }
+        return *this;
+    }
+    vector<bool, Alloc> &operator^= (const vector<bool, Alloc> &x) {
+        for(size_type i = 0, n = std::min(word_count(), x.word_count()); i < n; ++i) {
+            start.p[i] ^= operand_word(x, i, 0);
+        }
+        return *this;
+    }
+
+    friend bool operator== (const vector<bool, Alloc> &a, const vector<bool, Alloc> &b) {
+        if(a.size() != b.size()) {
+            return false;
+        }
+        size_type n = a.word_count();
+        for(size_type i = 0; i + 1 < n; ++i) {
+            if(a.start.p[i] != b.start.p[i]) {
+                return false;
+            }
+        }
+        return n == 0 || ((a.start.p[n - 1] ^ b.start.p[n - 1]) & a.tail_mask()) == 0;
+    }
+    friend bool operator!= (const vector<bool, Alloc> &a, const vector<bool, Alloc> &b) {
+        return !(a == b);
+    }
+    friend bool operator< (const vector<bool, Alloc> &a, const vector<bool, Alloc> &b) {
+        const_iterator i = a.begin(), j = b.begin();
+        for(; i != a.end() && j != b.end(); ++i, ++j) {
+            if(*i != *j) {
+                return *j;
+            }
+        }
+        return j != b.end();
+    }
+};
+
+typedef vector<bool, alloc> bit_vector;
+
 }
 
 #endif
@@ -0,0 +1,171 @@
+#ifndef __HH_STL_WORK_STEALING_DEQUE_H_
+#define __HH_STL_WORK_STEALING_DEQUE_H_
+
+#include<cstddef>
+#include<atomic>
+#include<type_traits>
+#include "hh_stl_alloc.h"
+#include "hh_stl_construct.h"
+#include "hh_config.h"
+
+namespace hh_std {
+
+// Chase-Lev work-stealing deque (with the C11 memory orders of Le, Pop, Cohen
+// and Zappa Nardelli, PPoPP 2013).  One owner thread calls push() and pop() at
+// the bottom; any number of thieves call steal() at the top.  The owner only
+// synchronizes with thieves when one element is left, and a steal is a
+// single CAS on top.
+//
+// The elements live in a power-of-two ring indexed by the absolute top/bottom
+// counters.  When it fills up, push() copies the live range into a ring twice
+// the size.  A thief may still be reading the old ring, so retired rings are
+// kept until the deque is destroyed; they add up to less than the live one.
+//
+// A thief reads its element before it knows whether the CAS will win, so the
+// slots are atomics and T must be trivially copyable (typically a task pointer).
+template <class T, class Alloc = alloc>
+class work_stealing_deque: private __alloc_holder<Alloc> {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "work_stealing_deque copies elements racily and needs a trivially copyable T");
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+protected:
+    typedef __alloc_holder<Alloc> alloc_base;
+
+    struct ring {
+        size_type mask;
+        std::atomic<T> *slots;
+        ring *prev;
+
+        T get(difference_type i) const {
+            return slots[size_type(i) & mask].load(std::memory_order_relaxed);
+        }
+        void put(difference_type i, const T &x) {
+            slots[size_type(i) & mask].store(x, std::memory_order_relaxed);
+        }
+    };
+    typedef simple_alloc<ring, Alloc> ring_allocator;
+    typedef simple_alloc<std::atomic<T>, Alloc> slot_allocator;
+
+    std::atomic<difference_type> top;
+    char pad0[__STL_CACHE_LINE_SIZE - sizeof(std::atomic<difference_type>)];
+    std::atomic<difference_type> bottom;
+    std::atomic<ring*> array;
+    char pad1[__STL_CACHE_LINE_SIZE - sizeof(std::atomic<difference_type>) - sizeof(std::atomic<ring*>)];
+
+    ring *new_ring(size_type n, ring *prev) {
+        ring *r = ring_allocator::allocate(this->get_alloc(), 1);
+        r->mask = n - 1;
+        r->slots = slot_allocator::allocate(this->get_alloc(), n);
+        r->prev = prev;
+        for(size_type i = 0; i < n; ++i) {
+            construct(r->slots + i);
+        }
+        return r;
+    }
+    ring *grow(ring *a, difference_type b, difference_type t) {
+        ring *r = new_ring(2 * (a->mask + 1), a);
+        for(difference_type i = t; i != b; ++i) {
+            r->put(i, a->get(i));
+        }
+        array.store(r, std::memory_order_release);
+        return r;
+    }
+public:
+    explicit work_stealing_deque(size_type n = 64, const allocator_type &a = allocator_type()): alloc_base(a) {
+        size_type cap = 2;
+        while(cap < n) {
+            cap <<= 1;
+        }
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+        array.store(new_ring(cap, 0), std::memory_order_relaxed);
+    }
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque &operator= (const work_stealing_deque&) = delete;
+    // Not thread safe: no other thread may be using the deque.
+    ~work_stealing_deque() {
+        ring *r = array.load(std::memory_order_relaxed);
+        while(r) {
+            ring *prev = r->prev;
+            slot_allocator::deallocate(this->get_alloc(), r->slots, r->mask + 1);
+            ring_allocator::deallocate(this->get_alloc(), r, 1);
+            r = prev;
+        }
+    }
+
+    allocator_type get_allocator() const {
+        return this->get_alloc();
+    }
+    // Snapshots; exact only when called by the owner with no thief running.
+    size_type size_approx() const {
+        difference_type b = bottom.load(std::memory_order_relaxed);
+        difference_type t = top.load(std::memory_order_relaxed);
+        return b > t ? size_type(b - t) : 0;
+    }
+    bool empty() const {
+        return size_approx() == 0;
+    }
+    size_type capacity() const {
+        return array.load(std::memory_order_relaxed)->mask + 1;
+    }
+
+    // Owner thread only.
+    void push(const T &x) {
+        difference_type b = bottom.load(std::memory_order_relaxed);
+        difference_type t = top.load(std::memory_order_acquire);
+        ring *a = array.load(std::memory_order_relaxed);
+        if(b - t > difference_type(a->mask)) {
+            a = grow(a, b, t);
+        }
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    // Owner thread only.  Takes the most recently pushed element; returns
+    // false if the deque is empty or a thief took the last element.
+    bool pop(T &out) {
+        difference_type b = bottom.load(std::memory_order_relaxed) - 1;
+        ring *a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        difference_type t = top.load(std::memory_order_relaxed);
+        if(t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if(t == b) {
+            // Last element: race the thieves for it.
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+    // Any thread.  Takes the oldest element; returns false if the deque looked
+    // empty or another thread won the race, in which case the caller usually
+    // moves on to another victim.
+    bool steal(T &out) {
+        difference_type t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        difference_type b = bottom.load(std::memory_order_acquire);
+        if(t >= b) {
+            return false;
+        }
+        ring *a = array.load(std::memory_order_acquire);
+        T x = a->get(t);
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = x;
+        return true;
+    }
+};
+
+};
+
+#endif
@@ -2,20 +2,38 @@
 #define __HH_TYPE_TRAITS_H_
 
 #include "hh_config.h"
+#include<type_traits>
 
 namespace hh_std {
 
 struct __true_type {};
 struct __false_type {};
 
+template <bool b>
+struct __bool_type {
+    typedef __false_type type;
+};
+
+__STL_TEMPLATE_NULL
+struct __bool_type<true> {
+    typedef __true_type type;
+};
+
+// The general case asks the compiler, so plain structs get the memmove and
+// no-destructor paths without a hand-written specialization.
 template <class type>
 struct __type_traits {
     typedef __true_type this_dummy_member_must_be_first;
-    typedef __false_type has_trivial_default_constructor;
-    typedef __false_type has_trivial_copy_constructor;
-    typedef __false_type has_trivial_assignment_operator;
-    typedef __false_type has_trivial_destructor;
-    typedef __false_type is_POD_type;
+    typedef typename __bool_type<std::is_trivially_default_constructible<type>::value>::type has_trivial_default_constructor;
+    typedef typename __bool_type<std::is_trivially_copy_constructible<type>::value>::type has_trivial_copy_constructor;
+    typedef typename __bool_type<std::is_trivially_copy_assignable<type>::value>::type has_trivial_assignment_operator;
+    typedef typename __bool_type<std::is_trivially_destructible<type>::value>::type has_trivial_destructor;
+    typedef typename __bool_type<std::is_trivial<type>::value &&
+                                 std::is_trivially_copy_assignable<type>::value>::type is_POD_type;
+    // An object that can be moved to new storage with memcpy, leaving the
+    // old bytes abandoned instead of destroyed.  Specialize for types that
+    // only hold pointers to storage they own and never point into themselves.
+    typedef typename __bool_type<std::is_trivially_copyable<type>::value>::type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -25,6 +43,7 @@ struct __type_traits<unsigned char> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -34,6 +53,7 @@ struct __type_traits<char> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -43,6 +63,7 @@ struct __type_traits<signed char> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -52,6 +73,7 @@ struct __type_traits<unsigned short> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -61,6 +83,7 @@ struct __type_traits<short> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -70,6 +93,7 @@ struct __type_traits<unsigned int> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -79,6 +103,7 @@ struct __type_traits<int> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -88,6 +113,7 @@ struct __type_traits<unsigned long> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -97,6 +123,7 @@ struct __type_traits<long> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -106,6 +133,7 @@ struct __type_traits<float> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -115,6 +143,7 @@ struct __type_traits<double> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 __STL_TEMPLATE_NULL
@@ -124,6 +153,7 @@ struct __type_traits<long double> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 template <class T>
@@ -133,6 +163,7 @@ struct __type_traits<T*> {
     typedef __true_type has_trivial_assignment_operator;
     typedef __true_type has_trivial_destructor;
     typedef __true_type is_POD_type;
+    typedef __true_type is_trivially_relocatable;
 };
 
 };